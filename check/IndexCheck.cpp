@@ -0,0 +1,236 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+// Cross-check of the fault index of FaultStore against a plain loop over all faults: random stores
+// shaped like the fault mix of a DIMM chip are queried through the index, before and after faults
+// are touched, removed, added and scrubbed. Then a benchmark of an existence query through the
+// index and through a scan of all faults, at growing store sizes, which FAULTSTORE_INDEX_MIN is
+// taken from. Exits with status 1 on the first disagreement.
+
+#include "FaultStore.hh"
+#include "DRAMDomain.hh"
+#include "FaultRange.hh"
+#include "Settings.hh"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include <sys/time.h>
+#include <boost/random/mersenne_twister.hpp>
+
+using namespace std;
+
+struct Settings settings;
+
+// a x4 chip of configs/DIMM_none.ini
+#define CHIP_BUS_BITS 4
+#define CHIP_RANKS 1
+#define CHIP_BANKS 8
+#define CHIP_ROWS 16384
+#define CHIP_COLS 2048
+
+#define CHECK_ROUNDS 40
+#define CHECK_QUERIES 300	// queries after each change of the store
+#define BENCH_MIN_N 32
+#define BENCH_MAX_N 4096
+#define BENCH_QUERIES 200000
+
+// the fault classes of DRAMDomain::generateRanges(), weighted by their FIT rates for faultmode 1
+// in main() (transient and permanent together)
+struct FaultClass
+{
+	bool rank, bank, row, col, bit;
+	double fit;
+	bool bank_wide;
+};
+
+static FaultClass classes[] = {
+	{ 1, 1, 1, 1, 1, 14.2 + 18.6, false },	// 1 bit
+	{ 1, 1, 1, 1, 0, 1.4 + 0.3, false },	// 1 word
+	{ 1, 1, 0, 1, 0, 1.4 + 5.6, false },	// 1 column
+	{ 1, 1, 1, 0, 0, 0.2 + 8.2, false },	// 1 row
+	{ 1, 1, 0, 0, 0, 0.8 + 10.0, true },	// 1 bank
+	{ 1, 0, 0, 0, 0, 0.3 + 1.4, true },		// n banks
+	{ 0, 0, 0, 0, 0, 0.9 + 2.8, true },		// n ranks
+};
+
+static boost::mt19937 eng;
+
+static FaultRange *randomFault( DRAMDomain *chip, bool bank_wide )
+{
+	uint32_t n_classes = sizeof( classes ) / sizeof( classes[0] );
+	double total = 0;
+	for( uint32_t c = 0; c < n_classes; c++ ) {
+		if( bank_wide || !classes[c].bank_wide ) total += classes[c].fit;
+	}
+
+	double pick = total * eng() / 4294967296.0;
+	uint32_t c = 0;
+	for( ; c < n_classes - 1; c++ ) {
+		if( !bank_wide && classes[c].bank_wide ) continue;
+		if( pick < classes[c].fit ) break;
+		pick -= classes[c].fit;
+	}
+
+	FaultClass &fc = classes[c];
+	FaultRange *fr = chip->genRandomRange( fc.rank, fc.bank, fc.row, fc.col, fc.bit, eng() % 2, -1, false );
+	fr->transient_remove = eng() % 2;
+	return fr;
+}
+
+// queries as the repair schemes make them: a fault, rounded to a symbol, a codeword, or (as for
+// the scrubbed faults ChipKill looks up) a whole bank or chip
+static void randomQuery( DRAMDomain *chip, FaultStore *store, uint64_t &addr, uint64_t &mask )
+{
+	if( store->size() != 0 && eng() % 2 == 0 ) {
+		uint32_t i = eng() % store->size();
+		addr = store->fAddr[i];
+		mask = store->fWildMask[i];
+	} else {
+		FaultRange *fr = randomFault( chip, true );
+		addr = fr->fAddr;
+		mask = fr->fWildMask;
+	}
+
+	switch( eng() % 4 ) {
+	case 0: mask |= ( 1ULL << 3 ) - 1; break;	// x4 symbol of 8 bits
+	case 1: mask |= ( 1ULL << 9 ) - 1; break;	// a cache line of a x4 chip
+	case 2: if( eng() % 4 == 0 ) mask |= ( 1ULL << store->getBankShift() ) - 1; break;
+	default: break;
+	}
+	addr &= ~mask;
+}
+
+static bool compare( FaultStore *store, DRAMDomain *chip, const char *when )
+{
+	vector<uint32_t> expected, found;
+
+	for( uint32_t q = 0; q < CHECK_QUERIES; q++ ) {
+		uint64_t addr, mask;
+		randomQuery( chip, store, addr, mask );
+
+		expected.clear();
+		bool expected_untouched = false;
+		for( uint32_t i = 0; i < store->size(); i++ ) {
+			if( !store->intersects( i, addr, mask ) ) continue;
+			expected.push_back( i );
+			if( store->untouched( i ) ) expected_untouched = true;
+		}
+
+		found.clear();
+		store->collectIntersecting( addr, mask, found );
+		sort( found.begin(), found.end() );
+
+		if( store->anyIntersecting( addr, mask, false ) != !expected.empty()
+				|| store->anyIntersecting( addr, mask, true ) != expected_untouched || found != expected ) {
+			printf( "FAIL: %s, %u faults: query %llx mask %llx finds %u faults through the index, a scan %u\n",
+				when, store->size(), (unsigned long long)addr, (unsigned long long)mask,
+				(unsigned)found.size(), (unsigned)expected.size() );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static double nowSeconds( void )
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// ns per anyIntersecting() query of a symbol, in a store of n faults without bank-wide ones (which
+// would end either search at once)
+static double benchQuery( DRAMDomain *chip, FaultStore *store, uint32_t n, uint32_t index_min )
+{
+	store->clear();
+	store->setQueryMins( index_min, FAULTSTORE_NO_INDEX );
+	for( uint32_t i = 0; i < n; i++ ) store->insert( randomFault( chip, false ) );
+
+	vector<uint64_t> addr( 1024 );
+	for( uint32_t q = 0; q < addr.size(); q++ ) {
+		FaultRange *fr = chip->genRandomRange( 1, 1, 1, 1, 1, false, -1, false );
+		addr[q] = fr->fAddr & ~7ULL;
+	}
+
+	uint32_t hits = store->anyIntersecting( addr[0], 7, false );	// builds the index
+	double start = nowSeconds();
+	for( uint32_t q = 0; q < BENCH_QUERIES; q++ ) {
+		hits += store->anyIntersecting( addr[q % addr.size()], 7, false );
+	}
+	return ( nowSeconds() - start ) * 1e9 / BENCH_QUERIES;
+}
+
+int main( int argc, char **argv )
+{
+	char name[] = "CHECK.DRAM0";
+	DRAMDomain *chip = new DRAMDomain( name, CHIP_BUS_BITS, CHIP_RANKS, CHIP_BANKS, CHIP_ROWS, CHIP_COLS );
+	FaultStore *store = chip->getRanges();
+	uint32_t sizes[] = { 0, 1, 7, 60, 400, 3000 };
+	uint32_t n_sizes = sizeof( sizes ) / sizeof( sizes[0] );
+	uint64_t n_checked = 0;
+
+	for( uint32_t round = 0; round < CHECK_ROUNDS; round++ ) {
+		uint32_t n = sizes[round % n_sizes];
+		bool bank_wide = round % 3 != 0;
+		char when[80];
+
+		// the point table would answer the queries within a symbol before the index sees them
+		store->clear();
+		store->setQueryMins( 0, FAULTSTORE_NO_INDEX );
+		store->setCoalescing( round % 2 != 0 );
+		for( uint32_t i = 0; i < n; i++ ) store->insert( randomFault( chip, bank_wide ) );
+		snprintf( when, sizeof( when ), "round %u, after insertion", round );
+		if( !compare( store, chip, when ) ) return 1;
+
+		// use up some faults: a single bit after one touch, wider ones after more
+		store->clearTouched();
+		for( uint32_t t = 0; t < store->size(); t++ ) {
+			uint32_t i = eng() % store->size();
+			for( uint32_t k = eng() % 3; k < 3; k++ ) store->touch( i );
+		}
+		snprintf( when, sizeof( when ), "round %u, after touching", round );
+		if( !compare( store, chip, when ) ) return 1;
+
+		// the index follows the compaction of the arrays
+		vector<uint32_t> indices;
+		for( uint32_t i = 0; i < store->size(); i++ ) {
+			if( eng() % 4 == 0 ) indices.push_back( i );
+		}
+		store->remove( indices );
+		snprintf( when, sizeof( when ), "round %u, after removal", round );
+		if( !compare( store, chip, when ) ) return 1;
+
+		for( uint32_t i = 0; i < n / 2 + 1; i++ ) store->insert( randomFault( chip, bank_wide ) );
+		snprintf( when, sizeof( when ), "round %u, after more insertions", round );
+		if( !compare( store, chip, when ) ) return 1;
+
+		store->scrub();
+		snprintf( when, sizeof( when ), "round %u, after scrubbing", round );
+		if( !compare( store, chip, when ) ) return 1;
+
+		n_checked += 5 * CHECK_QUERIES;
+	}
+
+	cout << "fault index: " << n_checked << " queries agree with a scan of all faults\n";
+
+	store->setCoalescing( false );
+	for( uint32_t n = BENCH_MIN_N; n <= BENCH_MAX_N; n *= 2 ) {
+		double scan = benchQuery( chip, store, n, FAULTSTORE_NO_INDEX );
+		double index = benchQuery( chip, store, n, 0 );
+		printf( "%u faults: %.1f ns per query with a scan, %.1f ns with the index\n", n, scan, index );
+	}
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+// Cross-check of the SIMD intersection kernels against the scalar one, and a microbenchmark of
+// each kernel the host CPU supports. Exits with status 1 on the first disagreement.
+
+#include "IntersectKernel.hh"
+#include "Settings.hh"
+#include <iostream>
+#include <vector>
+#include <sys/time.h>
+#include <boost/random/mersenne_twister.hpp>
+
+using namespace std;
+
+struct Settings settings;
+
+#define CHECK_MAX_N 300		// candidate counts 0..CHECK_MAX_N cover every tail length of every kernel
+#define CHECK_QUERIES 200	// queries per candidate count
+#define BENCH_N 1024		// candidates per benchmark query
+#define BENCH_QUERIES 200000
+
+struct Kernel
+{
+	const char *name;
+	IntersectFirstKernel first;
+	bool supported;
+};
+
+static boost::mt19937 eng;
+
+// ranges shaped like faults: mostly fixed bits, some runs of wild low bits
+static void randomRange( uint64_t &addr, uint64_t &mask )
+{
+	addr = ( (uint64_t)eng() << 32 ) | eng();
+	uint32_t wild = eng() % 24;
+	mask = ( wild == 0 ) ? 0 : ( ( (uint64_t)1 << wild ) - 1 ) << ( eng() % 8 );
+	if( eng() % 8 == 0 ) mask |= (uint64_t)0xFFFF << 40;
+}
+
+static double nowSeconds( void )
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+int main( int argc, char **argv )
+{
+	Kernel kernels[] = {
+		{ "scalar", intersectFirstScalar, true },
+		{ "avx2", intersectFirstAVX2, false },
+		{ "avx512", intersectFirstAVX512, false },
+	};
+	uint32_t n_kernels = sizeof( kernels ) / sizeof( kernels[0] );
+
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	kernels[1].supported = __builtin_cpu_supports( "avx2" );
+	kernels[2].supported = __builtin_cpu_supports( "avx512f" );
+#endif
+
+	vector<uint64_t> addr( CHECK_MAX_N ), mask( CHECK_MAX_N );
+	uint64_t n_checked = 0;
+
+	for( uint32_t n = 0; n <= CHECK_MAX_N; n++ ) {
+		for( uint32_t q = 0; q < CHECK_QUERIES; q++ ) {
+			for( uint32_t i = 0; i < n; i++ ) randomRange( addr[i], mask[i] );
+
+			uint64_t qAddr, qMask;
+			randomRange( qAddr, qMask );
+			// plant a hit at a random position in most queries
+			if( n != 0 && q % 4 != 0 ) {
+				uint32_t hit = eng() % n;
+				addr[hit] = ( qAddr & ~mask[hit] ) | ( addr[hit] & mask[hit] );
+			}
+
+			int64_t expected = intersectFirstScalar( &addr[0], &mask[0], n, qAddr, qMask );
+			for( uint32_t k = 1; k < n_kernels; k++ ) {
+				if( !kernels[k].supported ) continue;
+				int64_t found = kernels[k].first( &addr[0], &mask[0], n, qAddr, qMask );
+				if( found != expected ) {
+					cout << "FAIL: " << kernels[k].name << " returned " << found << " instead of " << expected
+					     << " for " << n << " candidates\n";
+					return 1;
+				}
+				n_checked++;
+			}
+		}
+	}
+
+	cout << "intersectFirst: " << n_checked << " queries agree with the scalar kernel\n";
+
+	// full scans without a hit
+	addr.resize( BENCH_N );
+	mask.resize( BENCH_N );
+	for( uint32_t i = 0; i < BENCH_N; i++ ) {
+		randomRange( addr[i], mask[i] );
+		mask[i] &= ~(uint64_t)1;
+		addr[i] &= ~(uint64_t)1;
+	}
+
+	for( uint32_t k = 0; k < n_kernels; k++ ) {
+		if( !kernels[k].supported ) {
+			cout << kernels[k].name << ": not supported by this CPU\n";
+			continue;
+		}
+
+		int64_t sum = 0;
+		double start = nowSeconds();
+		for( uint32_t q = 0; q < BENCH_QUERIES; q++ ) {
+			sum += kernels[k].first( &addr[0], &mask[0], BENCH_N, 1 | ( (uint64_t)q << 1 ), 0 );
+		}
+		double elapsed = nowSeconds() - start;
+
+		cout << kernels[k].name << ": " << elapsed * 1e9 / ( (double)BENCH_QUERIES * BENCH_N ) << " ns per candidate"
+		     << ( sum == -(int64_t)BENCH_QUERIES ? "" : " (unexpected hits)" ) << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+// Cross-check of the SIMD intersection kernels against the scalar one, and a microbenchmark of
+
+// Failed TSVs in a cube with on-die ECC: the TSV ranges must reach the module-level repair, and
+// take any fault the on-die code was correcting in their codewords with them. Exits with status 1
+// on the first violation.
+
+#include "GroupDomain_cube.hh"
+#include "DRAMDomain.hh"
+#include "FaultRange.hh"
+#include "Settings.hh"
+#include <iostream>
+#include <stdio.h>
+
+using namespace std;
+
+struct Settings settings;
+
+// the organisation of configs/3D_SECDED.ini
+#define CUBE_CHIPS 8
+#define CUBE_BANKS 8
+#define CUBE_ROWS 16384
+#define CUBE_COLS 64
+#define CUBE_BUS_BITS 32
+#define CUBE_BLOCK_BITS 512
+#define ONDIE_BITS 128
+
+static bool check( bool ok, const char *what )
+{
+	if( !ok ) cout << "FAIL: " << what << "\n";
+	return ok;
+}
+
+// does the module-level store hold no TSV fault, or only TSV faults?
+static bool allTSV( FaultStore *store, bool tsv )
+{
+	for( uint32_t i = 0; i < store->size(); i++ ) {
+		if( store->get( i ).TSV != tsv ) return false;
+	}
+	return true;
+}
+
+int main( int argc, char **argv )
+{
+	GroupDomain_cube *cube = new GroupDomain_cube( "MODULE0", 1, CUBE_CHIPS, CUBE_BANKS, CUBE_BLOCK_BITS, 0, 0, 0, true );
+	DRAMDomain *chips[CUBE_CHIPS];
+
+	for( uint32_t i = 0; i < CUBE_CHIPS; i++ ) {
+		char buf[40];
+		sprintf( buf, "MODULE0.DRAM%d", i );
+		chips[i] = new DRAMDomain( buf, CUBE_BUS_BITS, 1, CUBE_BANKS, CUBE_ROWS, CUBE_COLS );
+		chips[i]->setOnDieECC( ONDIE_BITS );
+		cube->addDomain( chips[i], i );
+	}
+
+	uint64_t lane = 5;
+	uint64_t rowbits = CUBE_COLS * CUBE_BUS_BITS;
+
+	// a single-bit fault on the lane of data TSV 5 of chip 0, corrected on-die
+	FaultRange bit( chips[0] );
+	bit.fAddr = ( ( 3ULL * CUBE_ROWS + 1234 ) * rowbits ) | ( 2 * cube->cube_data_tsv + lane );
+	bit.fWildMask = 0;
+	bit.max_faults = 1;
+	bit.transient = false;
+	bit.TSV = false;
+	chips[0]->insertRange( &bit );
+
+	bool ok = check( chips[0]->m_onDieRanges.size() == 1 && chips[0]->m_faultRanges.size() == 0,
+		"a lone single-bit fault is corrected on-die" );
+
+	// fail that TSV permanently, and a transient one of chip 1
+	cube->tsv_bitmap[lane] = true;
+	cube->tsv_info[lane] = 1;
+	cube->tsv_bitmap[cube->cube_data_tsv + lane] = true;
+	cube->tsv_info[cube->cube_data_tsv + lane] = 2;
+	for( uint32_t i = 0; i < CUBE_CHIPS; i++ ) chips[i]->updateTSV();
+
+	for( uint32_t i = 0; i < CUBE_CHIPS; i++ ) {
+		ok &= check( chips[i]->m_onDieRanges.size() == 0, "no fault is left with the on-die code" );
+	}
+	ok &= check( chips[0]->m_faultRanges.size() > 0 && !allTSV( &chips[0]->m_faultRanges, false ),
+		"the failed TSV of chip 0 reaches the module" );
+	ok &= check( chips[1]->m_faultRanges.size() > 0 && allTSV( &chips[1]->m_faultRanges, true ),
+		"the failed TSV of chip 1 reaches the module" );
+	ok &= check( chips[1]->getTransientRangeCount() == chips[1]->m_faultRanges.size(),
+		"the transient TSV ranges of chip 1 are counted" );
+	for( uint32_t i = 2; i < CUBE_CHIPS; i++ ) {
+		ok &= check( chips[i]->m_faultRanges.size() == 0, "chips without a failed TSV stay clean" );
+	}
+
+	if( !ok ) return 1;
+
+	cout << "on-die ECC: TSV faults of a cube go to the module-level repair\n";
+	return 0;
+}
@@ -0,0 +1,289 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+// Cross-check of the point table of FaultStore against a plain loop over all faults: random stores
+// of point faults, alone, with ranges, and with ranges wild in the bank (which turn the table off),
+// are queried within one ECC word through the table, as faults are touched, removed, added and
+// scrubbed, and across the wrap-around of the touched epochs. Then a benchmark of an existence
+// query within a symbol through the table and through a scan of all faults, at growing store
+// sizes, which FAULTSTORE_POINTS_QUERY_MIN is taken from. Exits with status 1 on the first
+// disagreement.
+
+#include "FaultStore.hh"
+#include "DRAMDomain.hh"
+#include "FaultRange.hh"
+#include "Settings.hh"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include <sys/time.h>
+#include <boost/random/mersenne_twister.hpp>
+
+using namespace std;
+
+struct Settings settings;
+
+// a x4 chip of configs/DIMM_none.ini
+#define CHIP_BUS_BITS 4
+#define CHIP_RANKS 1
+#define CHIP_BANKS 8
+#define CHIP_ROWS 16384
+#define CHIP_COLS 2048
+#define CODEWORD_BITS 9		// the point table of a chip under a scheme with 512-bit codewords
+
+#define CHECK_ROUNDS 45
+#define CHECK_QUERIES 300	// queries after each change of the store
+#define WRAP_FAULTS 200
+#define BENCH_MIN_N 16
+#define BENCH_MAX_N 2048
+#define BENCH_QUERIES 200000
+
+// the fault classes of DRAMDomain::generateRanges(), weighted by their FIT rates for faultmode 1
+// in main() (transient and permanent together). The point faults come first, the ranges wild in
+// the bank last.
+struct FaultClass
+{
+	bool rank, bank, row, col, bit;
+	double fit;
+};
+
+static FaultClass classes[] = {
+	{ 1, 1, 1, 1, 1, 14.2 + 18.6 },	// 1 bit
+	{ 1, 1, 1, 1, 0, 1.4 + 0.3 },	// 1 word
+	{ 1, 1, 0, 1, 0, 1.4 + 5.6 },	// 1 column
+	{ 1, 1, 1, 0, 0, 0.2 + 8.2 },	// 1 row
+	{ 1, 1, 0, 0, 0, 0.8 + 10.0 },	// 1 bank
+	{ 1, 0, 0, 0, 0, 0.3 + 1.4 },	// n banks
+	{ 0, 0, 0, 0, 0, 0.9 + 2.8 },	// n ranks
+};
+
+#define MIX_POINTS 2	// classes of each mix
+#define MIX_NARROW 4	// no fault covering a bank, which would end every search at once
+#define MIX_RANGES 5
+#define MIX_ALL 7
+
+static boost::mt19937 eng;
+
+static FaultRange *randomFault( DRAMDomain *chip, uint32_t n_classes )
+{
+	double total = 0;
+	for( uint32_t c = 0; c < n_classes; c++ ) total += classes[c].fit;
+
+	double pick = total * eng() / 4294967296.0;
+	uint32_t c = 0;
+	for( ; c < n_classes - 1; c++ ) {
+		if( pick < classes[c].fit ) break;
+		pick -= classes[c].fit;
+	}
+
+	FaultClass &fc = classes[c];
+	FaultRange *fr = chip->genRandomRange( fc.rank, fc.bank, fc.row, fc.col, fc.bit, eng() % 2, -1, false );
+	fr->transient_remove = eng() % 2;
+	return fr;
+}
+
+// queries within one ECC word, of a fault or a random address: one bit, a symbol, the whole word
+static void randomQuery( DRAMDomain *chip, FaultStore *store, uint32_t word_bits, uint64_t &addr, uint64_t &mask )
+{
+	if( store->size() != 0 && eng() % 4 != 0 ) {
+		uint32_t i = eng() % store->size();
+		addr = store->fAddr[i] | ( eng() & store->fWildMask[i] );
+	} else {
+		addr = chip->genRandomRange( 1, 1, 1, 1, 1, false, -1, false )->fAddr;
+	}
+
+	switch( eng() % 3 ) {
+	case 0: mask = 0; break;
+	case 1: mask = ( 1ULL << 3 ) - 1; break;
+	default: mask = ( 1ULL << word_bits ) - 1; break;
+	}
+	addr &= ~mask;
+}
+
+static bool compare( FaultStore *store, DRAMDomain *chip, uint32_t word_bits, const char *when )
+{
+	vector<uint32_t> expected, found;
+
+	for( uint32_t q = 0; q < CHECK_QUERIES; q++ ) {
+		uint64_t addr, mask;
+		randomQuery( chip, store, word_bits, addr, mask );
+		uint32_t start = eng() % ( store->size() + 1 );
+
+		expected.clear();
+		int64_t first = -1, first_untouched = -1;
+		for( uint32_t i = 0; i < store->size(); i++ ) {
+			if( !store->intersects( i, addr, mask ) ) continue;
+			expected.push_back( i );
+			if( i >= start && first == -1 ) first = i;
+			if( i >= start && first_untouched == -1 && store->untouched( i ) ) first_untouched = i;
+		}
+		bool any_untouched = false;
+		for( uint32_t k = 0; k < expected.size(); k++ ) {
+			if( store->untouched( expected[k] ) ) any_untouched = true;
+		}
+
+		found.clear();
+		store->collectIntersecting( addr, mask, found );
+		sort( found.begin(), found.end() );
+
+		if( store->anyIntersecting( addr, mask, false ) != !expected.empty()
+				|| store->anyIntersecting( addr, mask, true ) != any_untouched || found != expected
+				|| store->findIntersecting( addr, mask, false, start ) != first
+				|| store->findIntersecting( addr, mask, true, start ) != first_untouched ) {
+			printf( "FAIL: %s, %u faults: query %llx mask %llx from %u finds %u faults through the point table, a scan %u\n",
+				when, store->size(), (unsigned long long)addr, (unsigned long long)mask, start,
+				(unsigned)found.size(), (unsigned)expected.size() );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Touches made before the epochs wrap around must not count afterwards, even those of the epoch
+// the count restarts at
+static bool checkEpochWrap( DRAMDomain *chip, FaultStore *store )
+{
+	store->clear();
+	store->setQueryMins( FAULTSTORE_NO_INDEX, 0 );
+	for( uint32_t i = 0; i < WRAP_FAULTS; i++ ) store->insert( randomFault( chip, MIX_POINTS ) );
+
+	store->setEpoch( 1 );
+	for( uint32_t i = 0; i < store->size(); i += 5 ) store->touch( i );
+
+	store->setEpoch( 0xffffffff );
+	for( uint32_t i = 0; i < store->size(); i += 2 ) store->touch( i );
+	if( !compare( store, chip, FAULTSTORE_WORD_BITS, "last epoch before the wrap" ) ) return false;
+
+	store->clearTouched();
+	for( uint32_t i = 0; i < store->size(); i++ ) {
+		if( store->getTouched( i ) != 0 ) {
+			printf( "FAIL: fault %u is still touched after the epochs wrap around\n", i );
+			return false;
+		}
+	}
+	if( !compare( store, chip, FAULTSTORE_WORD_BITS, "first epoch after the wrap" ) ) return false;
+
+	for( uint32_t i = 0; i < store->size(); i += 3 ) store->touch( i );
+	for( uint32_t i = 0; i < store->size(); i++ ) {
+		if( store->getTouched( i ) != ( i % 3 == 0 ) ) {
+			printf( "FAIL: fault %u is touched %llu times after the wrap\n", i, (unsigned long long)store->getTouched( i ) );
+			return false;
+		}
+	}
+	return compare( store, chip, FAULTSTORE_WORD_BITS, "touched after the wrap" );
+}
+
+static double nowSeconds( void )
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// ns per anyIntersecting() query of a symbol, in a store of n faults smaller than a bank
+static double benchQuery( DRAMDomain *chip, FaultStore *store, uint32_t n, uint32_t points_min )
+{
+	store->clear();
+	store->setQueryMins( FAULTSTORE_NO_INDEX, points_min );
+	for( uint32_t i = 0; i < n; i++ ) store->insert( randomFault( chip, MIX_NARROW ) );
+
+	vector<uint64_t> addr( 1024 );
+	for( uint32_t q = 0; q < addr.size(); q++ ) {
+		FaultRange *fr = chip->genRandomRange( 1, 1, 1, 1, 1, false, -1, false );
+		addr[q] = fr->fAddr & ~7ULL;
+	}
+
+	uint32_t hits = 0;
+	double start = nowSeconds();
+	for( uint32_t q = 0; q < BENCH_QUERIES; q++ ) {
+		hits += store->anyIntersecting( addr[q % addr.size()], 7, false );
+	}
+	return ( nowSeconds() - start ) * 1e9 / BENCH_QUERIES;
+}
+
+int main( int argc, char **argv )
+{
+	char name[] = "CHECK.DRAM0";
+	char name_cw[] = "CHECK.DRAM1";
+	DRAMDomain *chips[2];
+	chips[0] = new DRAMDomain( name, CHIP_BUS_BITS, CHIP_RANKS, CHIP_BANKS, CHIP_ROWS, CHIP_COLS );
+	chips[1] = new DRAMDomain( name_cw, CHIP_BUS_BITS, CHIP_RANKS, CHIP_BANKS, CHIP_ROWS, CHIP_COLS );
+	chips[1]->getRanges()->setWordBits( CODEWORD_BITS );
+	uint32_t word_bits[] = { FAULTSTORE_WORD_BITS, CODEWORD_BITS };
+
+	uint32_t sizes[] = { 1, 12, 100, 900, 4000 };
+	uint32_t n_sizes = sizeof( sizes ) / sizeof( sizes[0] );
+	uint32_t mixes[] = { MIX_POINTS, MIX_RANGES, MIX_ALL };
+	uint64_t n_checked = 0;
+
+	for( uint32_t round = 0; round < CHECK_ROUNDS; round++ ) {
+		DRAMDomain *chip = chips[round % 2];
+		FaultStore *store = chip->getRanges();
+		uint32_t bits = word_bits[round % 2];
+		uint32_t n = sizes[round % n_sizes];
+		uint32_t mix = mixes[round % 3];
+		char when[80];
+
+		// the table keeps its slots across clear(), the next round starts from a used one
+		store->clear();
+		store->setQueryMins( FAULTSTORE_NO_INDEX, 0 );
+		store->setCoalescing( round % 4 == 1 );
+		for( uint32_t i = 0; i < n; i++ ) store->insert( randomFault( chip, mix ) );
+		snprintf( when, sizeof( when ), "round %u, after insertion", round );
+		if( !compare( store, chip, bits, when ) ) return 1;
+
+		store->clearTouched();
+		for( uint32_t t = 0; t < store->size(); t++ ) {
+			uint32_t i = eng() % store->size();
+			for( uint32_t k = eng() % 3; k < 3; k++ ) store->touch( i );
+		}
+		snprintf( when, sizeof( when ), "round %u, after touching", round );
+		if( !compare( store, chip, bits, when ) ) return 1;
+
+		// deletion, with all the ranges wild in the bank, which turns the table back on
+		vector<uint32_t> indices;
+		for( uint32_t i = 0; i < store->size(); i++ ) {
+			if( eng() % 3 == 0 || ( store->fWildMask[i] >> store->getBankShift() ) != 0 ) indices.push_back( i );
+		}
+		store->remove( indices );
+		snprintf( when, sizeof( when ), "round %u, after removal", round );
+		if( !compare( store, chip, bits, when ) ) return 1;
+
+		// enough to grow the table
+		for( uint32_t i = 0; i < n + 20; i++ ) store->insert( randomFault( chip, mix ) );
+		snprintf( when, sizeof( when ), "round %u, after more insertions", round );
+		if( !compare( store, chip, bits, when ) ) return 1;
+
+		store->scrub();
+		snprintf( when, sizeof( when ), "round %u, after scrubbing", round );
+		if( !compare( store, chip, bits, when ) ) return 1;
+
+		n_checked += 5 * CHECK_QUERIES;
+	}
+
+	chips[0]->getRanges()->setCoalescing( false );
+	if( !checkEpochWrap( chips[0], chips[0]->getRanges() ) ) return 1;
+	n_checked += 3 * CHECK_QUERIES;
+
+	cout << "point table: " << n_checked << " queries agree with a scan of all faults\n";
+
+	for( uint32_t n = BENCH_MIN_N; n <= BENCH_MAX_N; n *= 2 ) {
+		double scan = benchQuery( chips[0], chips[0]->getRanges(), n, FAULTSTORE_NO_INDEX );
+		double points = benchQuery( chips[0], chips[0]->getRanges(), n, 0 );
+		printf( "%u faults: %.1f ns per query with a scan, %.1f ns with the point table\n", n, scan, points );
+	}
+
+	return 0;
+}
@@ -13,24 +13,18 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #ifndef BCHREPAIR_HH_
 #define BCHREPAIR_HH_
 
-#include "RepairScheme.hh"
+#include "SymbolRepair.hh"
 
-class BCHRepair : public RepairScheme
+// Binary BCH code over a few locations of every chip (a CodewordLayout with one-bit symbols).
+// Stops at the first fault found uncorrectable or undetectable.
+
+class BCHRepair : public SymbolRepair
 {
 public:
-	// need to know how wide the devices are to determine which bits fall into one codeword
-	// across all the chips
-	BCHRepair( string name, int n_correct,int n_detect, uint64_t deviceBitWidth );
-	uint64_t fill_repl ( FaultDomain *fd );
-	void repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t &n_uncorrectable );
-
-	void printStats( void );
-	void resetStats( void );
-	void clear_counters ( void );
+	BCHRepair( string name, const CodewordLayout &layout );
 
 private:
-	uint64_t m_n_correct, m_n_detect, m_bitwidth;
-	uint64_t counter_prev, counter_now;
+	void evaluate( list<FaultDomain*> *pChips, uint64_t &n_undetectable, uint64_t &n_uncorrectable );
 };
 
 
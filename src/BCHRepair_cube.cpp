@@ -12,7 +12,10 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 #include "BCHRepair_cube.hh"
 #include "DRAMDomain.hh"
+#include "IntersectKernel.hh"
+#include <algorithm>
 #include "Settings.hh"
+#include <iostream>
 
 extern struct Settings settings;
 
@@ -24,6 +27,7 @@ BCHRepair_cube::BCHRepair_cube( string name, int n_correct, int n_detect, uint64
 	counter_prev=0;
 	counter_now=0;
 	m_log_block_bits = log2( data_block_bits );
+	m_covered.resize( ( (1ULL << m_log_block_bits) + 63 ) / 64 );
 }
 
 void BCHRepair_cube::repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t &n_uncorrectable )
@@ -32,7 +36,6 @@ void BCHRepair_cube::repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t
 
 	// Repair up to N bit faults in a single block
 	uint bit_shift=0;
-	uint loopcount_locations=0;
 	uint ii=0;
 	list<FaultDomain*> *pChips = fd->getChildren();
 	//assert( pChips->size() == (m_n_repair * 18) );
@@ -41,13 +44,7 @@ void BCHRepair_cube::repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t
 	for(it1 =pChips->begin(); it1 !=pChips->end(); it1++)
 	{
 		DRAMDomain *pDRAM1 = dynamic_cast<DRAMDomain*>((*it1));
-		list<FaultRange*> *pRange3 = pDRAM1->getRanges();
-		list<FaultRange*>::iterator itRange3;
-		for(itRange3 = pRange3->begin(); itRange3 !=pRange3->end(); itRange3++)
-		{
-			FaultRange *fr1 =(*itRange3);
-			fr1->touched=0;
-		}
+		pDRAM1->getRanges()->clearTouched();
 	}
 
 	// Take each chip in turn.  For every fault range in a chip, see which neighbors intersect it's ECC block(s).
@@ -55,46 +52,66 @@ void BCHRepair_cube::repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t
 	for( it0 = pChips->begin(); it0 != pChips->end(); it0++ )
 	{
 		DRAMDomain *pDRAM0 = dynamic_cast<DRAMDomain*>((*it0));
-		list<FaultRange*> *pRange0 = pDRAM0->getRanges();
+		FaultStore *pRange0 = pDRAM0->getRanges();
 
-		list<FaultRange*>::iterator itRange0;
-		for( itRange0 = pRange0->begin(); itRange0 != pRange0->end(); itRange0++ )
+		for( uint32_t i0 = 0; i0 < pRange0->size(); i0++ )
 		{
-			FaultRange *frOrg = (*itRange0); // The pointer to the fault location
-			FaultRange frTemp = *(*itRange0); //This is a fault location of a chip
-
-			uint32_t n_intersections = 0;
+			// a TSV fault is checked one block position of its stride at a time, as if each
+			// were a separate fault
+			uint64_t stride = pRange0->getTSVStride( i0, m_log_block_bits );
+			uint64_t stride_addr = 0;
+			do {
+				FaultQuery q = pRange0->getQuery( i0 );	//This is a fault location of a chip
+				q.addr |= stride_addr;
+				q.mask &= ~stride;
+
+				uint32_t n_intersections = 0;
 			
-			if(frTemp.touched < frTemp.max_faults)
-			{
-				if( settings.debug ) {
-					cout << m_name << ": outer " << frTemp.toString() << "\n";
-				}
-
-				bit_shift=m_log_block_bits;	//ECC every 64 byte i.e 512 bit granularity
-				frTemp.fAddr = frTemp.fAddr >> bit_shift;
-				frTemp.fAddr = frTemp.fAddr << bit_shift;
-				frTemp.fWildMask = frTemp.fWildMask >> bit_shift;
-				frTemp.fWildMask = frTemp.fWildMask << bit_shift;
-				loopcount_locations = 1 << bit_shift; // This gives me the number of loops for the addresses near the fault range to iterate
-
-				for(ii=0;ii<loopcount_locations;ii++)
+				if(pRange0->untouched( i0 ))
 				{
-					DRAMDomain *pDRAM1 = dynamic_cast<DRAMDomain*>((*it0));
-					list<FaultRange*> *pRange1 = pDRAM1->getRanges();
-					list<FaultRange*>::iterator itRange1;
-					for( itRange1 = pRange1->begin(); itRange1 != pRange1->end(); itRange1++ )
-					{
-						FaultRange *fr1 = (*itRange1);
+					if( settings.debug ) {
+						cout << m_name << ": outer " << pRange0->toString( i0 ) << "\n";
+					}
 
-						if( settings.debug ) {
-							cout << m_name << ": inner " << fr1->toString() << " bit " << ii << "\n";
+					bit_shift=m_log_block_bits;	//ECC every 64 byte i.e 512 bit granularity
+					uint64_t location_mask = ( 1ULL << bit_shift ) - 1;
+					q.addr &= ~location_mask;
+					q.mask &= ~location_mask;
+
+					// Only the locations covered by a fault of the chip that meets the block can
+					// find an intersection, and narrowing the search below only removes faults
+					// from the ones that meet it. Visit those locations in order, and at each one
+					// take the first of these faults that meets the narrowed search.
+					FaultStore *pRange1 = pRange0;
+					m_found.clear();
+					pRange1->collectIntersecting( q.addr, q.mask | location_mask, m_found );
+					sort( m_found.begin(), m_found.end() );
+
+					fill( m_covered.begin(), m_covered.end(), 0 );
+					for( uint32_t k = 0; k < m_found.size(); k++ ) {
+						uint32_t i1 = m_found[k];
+						if( pRange1->untouched( i1 ) ) {
+							blockCoverage( pRange1->fAddr[i1], pRange1->fWildMask[i1], bit_shift, &m_covered[0] );
 						}
+					}
 
-						if( fr1->touched < fr1->max_faults)
+					for( uint32_t w = 0; w < m_covered.size(); w++ )
+					{
+						for( uint64_t bits = m_covered[w]; bits != 0; bits &= bits - 1 )
 						{
-							if(frTemp.intersects(fr1)) {
-								if( settings.debug ) cout << m_name << ": INTERSECT " << n_intersections << "\n";
+							ii = w * 64 + __builtin_ctzll( bits );
+							q.addr = ( q.addr & ~location_mask ) | ii;
+
+							int64_t i1 = -1;
+							for( uint32_t k = 0; k < m_found.size() && i1 == -1; k++ ) {
+								uint32_t j = m_found[k];
+								if( pRange1->untouched( j ) && pRange1->intersects( j, q.addr, q.mask ) ) i1 = j;
+							}
+
+							if( i1 != -1 ) {
+								if( settings.debug ) {
+									cout << m_name << ": INTERSECT " << n_intersections << " " << pRange1->toString( i1 ) << " bit " << ii << "\n";
+								}
 
 								n_intersections++;
 
@@ -104,48 +121,57 @@ void BCHRepair_cube::repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t
 								// to both FaultRanges.  This is achieved by;
 								// 1) Set upper mask bits to zero if they are not wild in range under test
 								// 2) For those wild bits that we cleared, use the specific address bit value
-								uint64_t fr1_fAddr_upper = (fr1->fAddr >> bit_shift) << bit_shift;
-								uint64_t frTemp_fAddr_lower = (frTemp.fAddr & ((0x1 << bit_shift)-1) );
-
-								uint64_t old_wild_mask = frTemp.fWildMask;
-								frTemp.fWildMask &= fr1->fWildMask;
-								uint64_t changed_wild_bits = old_wild_mask ^ frTemp.fWildMask;
-								frTemp.fAddr = (fr1_fAddr_upper & changed_wild_bits) | (frTemp.fAddr & (~changed_wild_bits)) | frTemp_fAddr_lower;
+								uint64_t fr1_fAddr_upper = (pRange1->fAddr[i1] >> bit_shift) << bit_shift;
+								uint64_t frTemp_fAddr_lower = (q.addr & location_mask);
 
-								// immediately move on to the next location
-								break;
+								uint64_t old_wild_mask = q.mask;
+								q.mask &= pRange1->fWildMask[i1];
+								uint64_t changed_wild_bits = old_wild_mask ^ q.mask;
+								q.addr = (fr1_fAddr_upper & changed_wild_bits) | (q.addr & (~changed_wild_bits)) | frTemp_fAddr_lower;
 							} else {
-								if( settings.debug ) cout << m_name << ": NONE " << n_intersections << "\n";
+								if( settings.debug ) cout << m_name << ": NONE " << n_intersections << " bit " << ii << "\n";
 							}
 						}
 					}
-					frTemp.fAddr = frTemp.fAddr + 1;
-				}
 
-				// For this algorithm, one intersection with the bit being tested actually means one
-				// faulty bit in the
-				if(n_intersections <= m_n_correct)
-				{
-					// correctable
-				}
-				if(n_intersections > m_n_correct)
-				{
-					n_uncorrectable += (n_intersections - m_n_correct);
-					frOrg->transient_remove = false;
-					if( !settings.continue_running ) return;
-				}
-				if(n_intersections >= m_n_detect)
-				{
-					n_undetectable += (n_intersections - m_n_detect);
+					// For this algorithm, one intersection with the bit being tested actually means one
+					// faulty bit in the
+					if(n_intersections <= m_n_correct)
+					{
+						// correctable
+					}
+					if(n_intersections > m_n_correct)
+					{
+						n_uncorrectable += (n_intersections - m_n_correct);
+						pRange0->transient_remove[i0] = false;
+						if( !settings.continue_running ) return;
+					}
+					if(n_intersections >= m_n_detect)
+					{
+						n_undetectable += (n_intersections - m_n_detect);
+					}
 				}
-			}
+				stride_addr = (stride_addr - stride) & stride;
+			} while( stride_addr != 0 );
 		}
 	}
 }
 
-uint64_t BCHRepair_cube::fill_repl(FaultDomain *fd)
+// A fault alone in its block only meets itself, once for every location of the block it covers
+
+bool BCHRepair_cube::isolatedCorrectable( uint64_t fWildMask, uint32_t row_shift )
+{
+	if( m_log_block_bits > row_shift ) return false;
+
+	uint64_t n_intersections = 1ULL << __builtin_popcountll( fWildMask & ((0x1ULL << m_log_block_bits)-1) );
+	return n_intersections <= m_n_correct && n_intersections < m_n_detect;
+}
+
+// one ECC block
+
+uint32_t BCHRepair_cube::getCodewordBits( void )
 {
-	return 0;
+	return m_log_block_bits;
 }
 void BCHRepair_cube::printStats( void )
 {
@@ -14,6 +14,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #define BCHREPAIR_CUBE_HH_
 
 #include "RepairScheme.hh"
+#include <vector>
 
 class BCHRepair_cube : public RepairScheme
 {
@@ -21,8 +22,9 @@ public:
 	// need to know how wide the devices are to determine which bits fall into one codeword
 	// across all the chips
 	BCHRepair_cube( string name, int n_correct,int n_detect, uint64_t data_block_bits );
-	uint64_t fill_repl ( FaultDomain *fd );
+	uint32_t getCodewordBits( void );
 	void repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t &n_uncorrectable );
+	bool isolatedCorrectable( uint64_t fWildMask, uint32_t row_shift );
 
 	void printStats( void );
 	void resetStats( void );
@@ -31,6 +33,8 @@ public:
 private:
 	uint64_t m_n_correct, m_n_detect, m_bitwidth, m_log_block_bits;
 	uint64_t counter_prev, counter_now;
+	vector<uint32_t> m_found;	// faults of the chip meeting the block of a fault
+	vector<uint64_t> m_covered;	// locations of the block covered by them
 };
 
 
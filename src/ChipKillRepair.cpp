@@ -12,108 +12,232 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 #include "ChipKillRepair.hh"
 #include "DRAMDomain.hh"
+#include <algorithm>
 
-ChipKillRepair::ChipKillRepair( string name, int n_sym_correct, int n_sym_detect ) : RepairScheme( name )
-, m_n_correct(n_sym_correct)
-, m_n_detect(n_sym_detect)
+ChipKillRepair::ChipKillRepair( string name, const CodewordLayout &layout ) : RepairScheme( name )
+, m_layout(layout)
+, m_n_correct(layout.n_correct)
+, m_n_detect(layout.n_detect)
+, m_symbol_mask((1ULL << layout.log_symbol)-1)
+, m_fd(NULL)
+, m_n_undetectable(0)
+, m_n_uncorrectable(0)
 {
 counter_prev=0;
 counter_now=0;
+assert( layout.log_codeword == layout.log_symbol );
 }
 
+// For every fault range, count the number of chips holding a fault that intersects it
+// (rounded to a symbol of the layout), including its own chip. If the count exceeds the correction
+// ability, fail.
+//
+// Two faults intersect after rounding if every address bit outside the symbol bits is wild in
+// one of them or equal in both, which is symmetric. The count of a fault therefore only changes
+// when an intersecting fault is inserted or scrubbed, so the per-chip hit counts are kept across
+// calls and each call only evaluates the faults added or removed since the previous one.
+
 void ChipKillRepair::repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t &n_uncorrectable )
 {
-	n_undetectable = n_uncorrectable = 0;
-	// Repair this module.  Assume 8-bit symbols.
-
 	list<FaultDomain*> *pChips = fd->getChildren();
-	// make sure number of children is appropriate for level of ChipKill
+	// make sure number of children is appropriate for the layout
 	// i.e. 18 chips per chipkill
-	assert( pChips->size() == (m_n_correct * 18) );
-	list<FaultDomain*>::iterator it0, it1;
-	
-	//Clear out the touched values for all chips
-	for( it1 = pChips->begin(); it1 != pChips->end(); it1++ )
-	{
-		DRAMDomain *pDRAM3 = dynamic_cast<DRAMDomain*>((*it1));
-		list<FaultRange*> *pRange3 = pDRAM3->getRanges();
-		list<FaultRange*>::iterator itRange3;
-		for( itRange3 = pRange3->begin(); itRange3 != pRange3->end(); itRange3++ )
-		{
-			FaultRange *fr2 = (*itRange3);
-			fr2->touched=0;
+	assert( pChips->size() == m_layout.chips );
+
+	// the stores are refilled in place, so that a call does not allocate once the state has grown
+	vector<FaultStore*> &stores = m_stores;
+	stores.clear();
+	list<FaultDomain*>::iterator it;
+	for( it = pChips->begin(); it != pChips->end(); it++ ) {
+		DRAMDomain *pDRAM = dynamic_cast<DRAMDomain*>((*it));
+		stores.push_back( pDRAM->getRanges() );
+	}
+
+	if( fd != m_fd || m_chips.size() != stores.size() ) resetState( fd, stores );
+
+	// catch up with faults removed since the last call; the scrub log only covers one generation
+	bool scrubbed = false;
+	for( uint32_t c = 0; c < stores.size(); c++ ) {
+		FaultStore *pRange = stores[c];
+		ChipState &state = m_chips[c];
+		if( pRange->getGeneration() == state.generation ) continue;
+
+		if( pRange->getGeneration() != state.generation + 1 || pRange->scrubbed.empty()
+				|| pRange->scrubbed.back() >= state.known ) {
+			resetState( fd, stores );
+			scrubbed = false;
+			break;
 		}
+		scrubbed = true;
 	}
-	uint32_t n_intersections;
-	// Take each chip in turn.  For every fault range,
-	// count the number of intersecting faults (rounded to an 8-bit range).
-	// if count exceeds correction ability, fail.
-	for( it0 = pChips->begin(); it0 != pChips->end(); it0++ )
-	{
-		DRAMDomain *pDRAM0 = dynamic_cast<DRAMDomain*>((*it0));
-		list<FaultRange*> *pRange0 = pDRAM0->getRanges();
-
-		// For each fault in first chip, query the second chip to see if it has
-		// an intersecting fault range.
-		list<FaultRange*>::iterator itRange0;
-		for( itRange0 = pRange0->begin(); itRange0 != pRange0->end(); itRange0++ )
-		{
-			// tweak the query range to cover 8-bit block
-			// Make a copy, otherwise fault is modified as a side-effect
-			FaultRange *frOrg = (*itRange0); // The pointer to the fault location
-			FaultRange frTemp = *(*itRange0);
-			frTemp.fWildMask |= ((0x1<<3)-1);
-		    n_intersections = 0;
-			if(frTemp.touched<frTemp.max_faults)
-			{
-				// for each other chip, count number of intersecting faults
-				for( it1 = pChips->begin(); it1 != pChips->end(); it1++ )
-				{
-                    DRAMDomain *pDRAM1 = dynamic_cast<DRAMDomain*>((*it1));
-					list<FaultRange*> *pRange1 = pDRAM1->getRanges();
-					list<FaultRange*>::iterator itRange1;
-					for( itRange1 = pRange1->begin(); itRange1 != pRange1->end(); itRange1++ )
-					{
-						FaultRange *fr1 = (*itRange1);
-						
-                       // if (frTemp.Chip!=fr1->Chip)
-                       // {
-                          if((frTemp.intersects(fr1)) ) {  //&& (fr1->touched < fr1->max_faults)
-					        	// count the intersection
-                                n_intersections++;
-		        				break;  
-                                }
-                       // }
-                    }//end of Range loop
-                } //end of Chip loop
+	if( scrubbed ) removeScrubbed( stores );
+
+	// evaluate the faults inserted since the last call
+	for( uint32_t c = 0; c < stores.size(); c++ ) {
+		for( uint32_t i = m_chips[c].known; i < stores[c]->size(); i++ ) {
+			addFault( stores, c, i );
+		}
+	}
+
+	n_undetectable = m_n_undetectable;
+	n_uncorrectable = m_n_uncorrectable;
+}
+
+void ChipKillRepair::resetState( FaultDomain *fd, vector<FaultStore*> &stores )
+{
+	m_fd = fd;
+	m_chips.resize( stores.size() );
+	for( uint32_t c = 0; c < stores.size(); c++ ) {
+		m_chips[c].generation = stores[c]->getGeneration();
+		m_chips[c].known = 0;
+		m_chips[c].hits.clear();
+		m_chips[c].n_chips.clear();
+		m_chips[c].counted.clear();
+		// room for the usual handful of faults per chip, so that inserting them does not allocate
+		m_chips[c].hits.reserve( CHIPKILLREPAIR_RESERVE_FAULTS * stores.size() );
+		m_chips[c].n_chips.reserve( CHIPKILLREPAIR_RESERVE_FAULTS );
+		m_chips[c].counted.reserve( CHIPKILLREPAIR_RESERVE_FAULTS );
+	}
+	m_n_undetectable = m_n_uncorrectable = 0;
+}
+
+void ChipKillRepair::removeScrubbed( vector<FaultStore*> &stores )
+{
+	uint32_t n_chips = stores.size();
+
+	// drop the state of the removed faults, compacting it the same way as the FaultStore
+	for( uint32_t c = 0; c < n_chips; c++ ) {
+		FaultStore *pRange = stores[c];
+		ChipState &state = m_chips[c];
+		if( pRange->getGeneration() == state.generation ) continue;
+
+		uint32_t j = 0;
+		uint32_t r = 0;
+		for( uint32_t i = 0; i < state.known; i++ ) {
+			if( r < pRange->scrubbed.size() && pRange->scrubbed[r] == i ) {
+				if( state.counted[i] ) addTotals( state.n_chips[i], -1 );
+				r++;
+				continue;
 			}
-           if(n_intersections <= m_n_correct)
-			{
-				if(frOrg->fWildMask > m_n_correct)
-				frOrg->transient_remove = false;
+			if( i != j ) {
+				copy( state.hits.begin() + i * n_chips, state.hits.begin() + (i + 1) * n_chips, state.hits.begin() + j * n_chips );
+				state.n_chips[j] = state.n_chips[i];
+				state.counted[j] = state.counted[i];
 			}
-			if( n_intersections >= m_n_correct) 
-			{
-				n_uncorrectable = (n_intersections - m_n_correct)+n_uncorrectable;
-				frOrg->transient_remove = false;
+			j++;
+		}
+		state.known = j;
+		state.hits.resize( j * n_chips );
+		state.n_chips.resize( j );
+		state.counted.resize( j );
+	}
+
+	// the remaining faults lose the hits of the removed ones
+	for( uint32_t c0 = 0; c0 < n_chips; c0++ ) {
+		FaultStore *pRange0 = stores[c0];
+		ChipState &state0 = m_chips[c0];
+		if( pRange0->getGeneration() == state0.generation ) continue;
+		state0.generation = pRange0->getGeneration();
+
+		for( uint32_t r = 0; r < pRange0->scrubbed.size(); r++ ) {
+			FaultQuery q;
+			q.addr = pRange0->scrubbedAddr[r];
+			q.mask = pRange0->scrubbedWildMask[r] | m_symbol_mask;
+			q.max_faults = 0;
+			q.flags = 0;
+
+			for( uint32_t c1 = 0; c1 < n_chips; c1++ ) {
+				FaultStore *pRange1 = stores[c1];
+				ChipState &state1 = m_chips[c1];
+				m_found.clear();
+				pRange1->collectIntersecting( q, m_found );
+				for( uint32_t k = 0; k < m_found.size(); k++ ) {
+					uint32_t i1 = m_found[k];
+					if( i1 >= state1.known ) continue;
+					if( --state1.hits[i1 * n_chips + c0] == 0 ) {
+						setChipCount( pRange1, state1, i1, state1.n_chips[i1] - 1 );
+					}
+				}
 			}
-			if( n_intersections >= m_n_detect) {
-				n_undetectable = (n_intersections - m_n_detect)+n_undetectable;
+		}
+	}
+}
+
+void ChipKillRepair::addFault( vector<FaultStore*> &stores, uint32_t chip, uint32_t i )
+{
+	uint32_t n_chips = stores.size();
+	ChipState &state = m_chips[chip];
+
+	// tweak the query range to cover a symbol
+	FaultQuery q = stores[chip]->getQuery( i );
+	q.mask |= m_symbol_mask;
+
+	assert( i == state.known );
+	state.hits.resize( (i + 1) * n_chips, 0 );
+	state.n_chips.push_back( 0 );
+	state.counted.push_back( q.max_faults != 0 );
+	state.known = i + 1;
+
+	// every evaluated fault intersecting the new one gains a hit on its chip, and the other way round
+	uint32_t n_hit_chips = 0;
+	for( uint32_t c1 = 0; c1 < n_chips; c1++ ) {
+		FaultStore *pRange1 = stores[c1];
+		ChipState &state1 = m_chips[c1];
+		uint32_t hits = 0;
+
+		m_found.clear();
+		pRange1->collectIntersecting( q, m_found );
+		for( uint32_t k = 0; k < m_found.size(); k++ ) {
+			uint32_t i1 = m_found[k];
+			if( i1 >= state1.known ) continue;
+			hits++;
+			if( c1 == chip && i1 == i ) continue;
+			if( state1.hits[i1 * n_chips + chip]++ == 0 ) {
+				setChipCount( pRange1, state1, i1, state1.n_chips[i1] + 1 );
 			}
-            
 		}
+
+		state.hits[i * n_chips + c1] = hits;
+		if( hits != 0 ) n_hit_chips++;
 	}
-//    if(n_intersections>2)
-  //  n_undetectable++;
-  //  else if (n_intersections==1)
-  //  n_uncorrectable++;
 
+	setChipCount( stores[chip], state, i, n_hit_chips );
+}
 
+// Update the number of chips intersecting a fault, with its contribution to the totals
+
+void ChipKillRepair::setChipCount( FaultStore *pRange, ChipState &state, uint32_t i, uint32_t n_chips )
+{
+	// a fault without max_faults is never counted
+	uint64_t n_after = state.counted[i] ? n_chips : 0;
+	if( state.counted[i] ) {
+		addTotals( state.n_chips[i], -1 );
+		addTotals( n_chips, 1 );
+	}
+	state.n_chips[i] = n_chips;
+
+	if( n_after <= m_n_correct )
+	{
+		if( pRange->fWildMask[i] > m_n_correct )
+		pRange->transient_remove[i] = false;
+	}
+	if( n_after >= m_n_correct )
+	{
+		pRange->transient_remove[i] = false;
+	}
+}
+
+void ChipKillRepair::addTotals( uint64_t n_chips, int64_t sign )
+{
+	if( n_chips >= m_n_correct ) m_n_uncorrectable += sign * (n_chips - m_n_correct);
+	if( n_chips >= m_n_detect ) m_n_undetectable += sign * (n_chips - m_n_detect);
 }
 
-uint64_t ChipKillRepair::fill_repl(FaultDomain *fd)
+// one symbol
+
+uint32_t ChipKillRepair::getCodewordBits( void )
 {
-return 0;
+	return m_layout.log_symbol;
 }
 void ChipKillRepair::printStats( void )
 {
@@ -14,21 +14,59 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #define CHIPKILLREPAIR_HH_
 
 #include "RepairScheme.hh"
+#include "CodewordLayout.hh"
+#include <vector>
+
+#define CHIPKILLREPAIR_RESERVE_FAULTS 8	// faults per chip the state is sized for up front
+
+class FaultStore;
+
+// ChipKill over a CodewordLayout with one symbol per chip (CK1, CK2). It is not a SymbolRepair:
+// it keeps the verdicts of the original scheme, which fails a fault once as many chips as it can
+// correct meet it, and keeps such faults, and correctable ones with wide wildcards, from being
+// scrubbed. SymbolRepair with the same layout is the textbook code and gives lower failure rates.
+// Its per-chip counts are also kept across repair() calls, which SymbolRepair cannot do for
+// layouts with several symbols per chip.
 
 class ChipKillRepair : public RepairScheme
 {
 public:
-	ChipKillRepair( string name, int n_sym_correct, int n_sym_detect );
+	ChipKillRepair( string name, const CodewordLayout &layout );	// one symbol per chip
 
 	void repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t &n_uncorrectable );
-	uint64_t fill_repl ( FaultDomain *fd );
+	uint32_t getCodewordBits( void );
 	void printStats( void );
 	void resetStats( void );
 	void clear_counters( void );
 
 private:
+	// Per chip evaluation state kept across repair() calls, so that a call only evaluates the
+	// interactions of the faults inserted or removed since the previous one.
+	struct ChipState
+	{
+		uint64_t generation;	// FaultStore generation the state refers to
+		uint32_t known;	// faults [0, known) of the chip have been evaluated
+		vector<uint32_t> hits;	// per fault and chip, number of faults of that chip intersecting its symbol
+		vector<uint32_t> n_chips;	// per fault, number of chips with at least one hit
+		vector<uint8_t> counted;	// per fault, whether it adds to the totals (max_faults is set)
+	};
+
+	void resetState( FaultDomain *fd, vector<FaultStore*> &stores );
+	void removeScrubbed( vector<FaultStore*> &stores );
+	void addFault( vector<FaultStore*> &stores, uint32_t chip, uint32_t i );
+	void setChipCount( FaultStore *pRange, ChipState &state, uint32_t i, uint32_t n_chips );
+	void addTotals( uint64_t n_chips, int64_t sign );
+
+	CodewordLayout m_layout;
 	uint64_t m_n_correct, m_n_detect;
+	uint64_t m_symbol_mask;	// address bits of the locations of a symbol
 	uint64_t counter_prev, counter_now;
+
+	FaultDomain *m_fd;	// module the state belongs to
+	vector<FaultStore*> m_stores;	// of the chips of the module, in order
+	vector<ChipState> m_chips;
+	uint64_t m_n_undetectable, m_n_uncorrectable;	// totals over all faults of the module
+	vector<uint32_t> m_found;	// intersecting faults of a query
 };
 
 
@@ -17,6 +17,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 ChipKillRepair_cube::ChipKillRepair_cube( string name, int n_sym_correct, int n_sym_detect,FaultDomain *fd) : RepairScheme( name )
 , m_n_correct(n_sym_correct)
 , m_n_detect(n_sym_detect)
+, m_fd(NULL)
 {
 counter_prev=0;
 counter_now=0;
@@ -49,209 +50,199 @@ void ChipKillRepair_cube::repair( FaultDomain *fd, uint64_t &n_undetectable, uin
 void ChipKillRepair_cube::repair_hc(FaultDomain *fd, uint64_t &n_undetect, uint64_t &n_uncorrect)
 {
 	n_undetect = n_uncorrect= 0;
-	list<FaultDomain*> *pChips = fd->getChildren();
-	list<FaultDomain*>::iterator it0, it1;
 	uint64_t ii=0;
 	//Initialize the counters to count chips
 	uint64_t counter1 =0;
 	uint64_t counter2 =0;
 
 	int64_t bank_number1=0;	
-	int64_t bank_number2=0;
-	//Clear out the touched values for all chips
-	for(it1 = pChips->begin(); it1 !=pChips->end(); it1++)
+	//Clear out the touched values for all chips, and bucket the new faults by bank
+	updateBanks( fd );
+	for( uint32_t c = 0; c < m_stores.size(); c++ )
 	{
-		DRAMDomain *pDRAM =dynamic_cast<DRAMDomain*>((*it1));
-		list<FaultRange*> *pRange3 = pDRAM->getRanges();
-		list<FaultRange*>::iterator itRange3;
-		for(itRange3 = pRange3->begin(); itRange3 != pRange3->end(); itRange3++)
-		{
-			FaultRange *fr1 = (*itRange3);
-			fr1->touched=0;
-		}
+		m_stores[c]->clearTouched();
 	}
 
+	//Adjusting for number of banks
+	uint64_t bit_shift = logBits+logRows+logCols;
+	uint64_t lower_mask = (1ULL<<bit_shift)-1;
+
 	//Take the 1st Chip and check if other chips also fail. We use only upto 8 chips
-	for( it0 = pChips->begin(); it0 != pChips->end(); it0++ )
+	for( uint32_t c0 = 0; c0 < m_stores.size(); c0++ )
 	{
-		DRAMDomain *pDRAM0 = dynamic_cast<DRAMDomain*>((*it0));
-		list<FaultRange*> *pRange0 = pDRAM0->getRanges();
+		FaultStore *pRange0 = m_stores[c0];
 
 		// For each fault in first chip, query the second chip to see if it has
 		// an intersecting fault range.
-		list<FaultRange*>::iterator itRange0;
-		for( itRange0 = pRange0->begin(); itRange0 != pRange0->end(); itRange0++ )
+		for( uint32_t i0 = 0; i0 < pRange0->size(); i0++ )
 		{
-			// Make a copy, otherwise fault is modified as a side-effect
-			FaultRange frTemp = *(*itRange0);
-			//8 Bytes are protected per chip
-			frTemp.fWildMask = ((0x1<<6)-1);
-			uint32_t n_intersections = 0;
-			counter2=0;
-			// for each other chip, count number of intersecting faults
-			for (ii=0;ii<banks;ii++ )
-			{		
-				//Adjusting for number of banks
-				uint64_t bit_shift = logBits+logRows+logCols;
-				uint64_t and_value = 1<<(logBits+logRows+logCols);
-					 and_value=and_value-1;
-				uint64_t lower_addr = frTemp.fAddr & and_value;
-				frTemp.fAddr = frTemp.fAddr>>(3+bit_shift);			//8 Banks
-				frTemp.fAddr = frTemp.fAddr<<3;
-				frTemp.fAddr = frTemp.fAddr+ii;
-				frTemp.fAddr = frTemp.fAddr<<bit_shift;
-				frTemp.fAddr = frTemp.fAddr | lower_addr;
-
-				//Start looping accross chips
-				for(it1 = pChips->begin(); it1 != pChips->end(); it1++ )
-				{
-					DRAMDomain *pDRAM1 = dynamic_cast<DRAMDomain*>((*it1));
-					list<FaultRange*> *pRange1 = pDRAM1->getRanges();
-					if(counter1<2 && counter2<2)
+			// a TSV fault is checked one protected word of its stride at a time, as if each were a
+			// separate fault
+			uint64_t stride = pRange0->getTSVStride( i0, 6 );
+			uint64_t stride_addr = 0;
+			do {
+				FaultQuery q = pRange0->getQuery( i0 );
+				q.addr |= stride_addr;
+				//8 Bytes are protected per chip
+				q.mask = ((0x1<<6)-1);
+				uint32_t n_intersections = 0;
+				counter2=0;
+				// for each other chip, count number of intersecting faults
+				for (ii=0;ii<banks;ii++ )
+				{		
+					// move the query to bank ii (8 Banks), only the faults of that bank and the
+					// bank-wild ones can intersect it
+					q.addr = (((q.addr>>(3+bit_shift))<<3)+ii)<<bit_shift | (q.addr & lower_mask);
+
+					//Start looping accross chips
+					for( uint32_t c1 = 0; c1 < m_stores.size(); c1++ )
 					{
-						list<FaultRange*>::iterator itRange1;
-						for( itRange1 = pRange1->begin(); itRange1 != pRange1->end(); itRange1++ )
+						if(counter1<2 && counter2<2)
 						{
-							FaultRange *fr1 = (*itRange1);
-							if( frTemp.intersects( fr1 ) ) {
-							// count the intersection
-							n_intersections++;
-							fr1->touched++;
-							break;
-							}
+							if( anyInBank( c1, q.addr, q.mask, ii, CK_CUBE_PAIR_ANY, bank_number1 ) ) n_intersections++;
 						}
-					}
-					if((counter1<2 || counter2<2)&& (counter1==4 || counter2==4))
-					{
-						list<FaultRange*>::iterator itRange1;
-						for( itRange1 = pRange1->begin(); itRange1 != pRange1->end(); itRange1++ )
+						if((counter1<2 || counter2<2)&& (counter1==4 || counter2==4))
 						{
-							FaultRange *fr1 = (*itRange1);
-							bank_number2 = getbank_number(*fr1);
-							if(bank_number1 !=-1 && bank_number2 !=-1) 
-							{
-								if(bank_number2==(bank_number1>>1))
-								{
-									if( frTemp.intersects( fr1 ) ) {
-									// count the intersection
-									n_intersections++;
-									fr1->touched++;
-									break;
-									}
-								}
-							}
-							else if((bank_number1 == -1) && (bank_number2 <4) && (bank_number2>-1))
-							{
-								if( frTemp.intersects( fr1 ) ) {
-								// count the intersection
-								n_intersections++;
-								fr1->touched++;
-								break;
-								}
-		
-							}
-							else if((bank_number2 == -1))
-							{
-								if( frTemp.intersects( fr1 ) ) {
-								// count the intersection
-								n_intersections++;
-								fr1->touched++;
-								break;
-								}
-		
-							}
-
-							
+							if( anyInBank( c1, q.addr, q.mask, ii, CK_CUBE_PAIR_LOW, bank_number1 ) ) n_intersections++;
 						}
-					}
-					if(counter1>1 && counter1<4 && counter2>1 && counter2<4)
-					{
-						list<FaultRange*>::iterator itRange1;
-						for( itRange1 = pRange1->begin(); itRange1 != pRange1->end(); itRange1++ )
+						if(counter1>1 && counter1<4 && counter2>1 && counter2<4)
 						{
-							FaultRange *fr1 = (*itRange1);
-							if( frTemp.intersects( fr1 ) ) {
-								// count the intersection
-								n_intersections++;
-								fr1->touched++;
-								break;
-							}
+							if( anyInBank( c1, q.addr, q.mask, ii, CK_CUBE_PAIR_ANY, bank_number1 ) ) n_intersections++;
 						}
-					}
-					if(((counter1>1 && counter1<4) || (counter2>1 && counter2<4))&& (counter1==4 || counter2==4))
-					{
-						list<FaultRange*>::iterator itRange1;
-						for( itRange1 = pRange1->begin(); itRange1 != pRange1->end(); itRange1++ )
+						if(((counter1>1 && counter1<4) || (counter2>1 && counter2<4))&& (counter1==4 || counter2==4))
 						{
-							FaultRange *fr1 = (*itRange1);
-							bank_number2 = getbank_number(*fr1);
-							if(bank_number2==((bank_number1>>1)|0x4))
-							{
-								if( frTemp.intersects( fr1 ) ) {
-									// count the intersection
-									n_intersections++;
-									fr1->touched++;
-									break;
-								}
-							}
+							if( anyInBank( c1, q.addr, q.mask, ii, CK_CUBE_PAIR_HIGH, bank_number1 ) ) n_intersections++;
 						}
-					}
-					if(counter1>4 && counter1<7 && counter2>4 && counter2<7)
-					{
-						list<FaultRange*>::iterator itRange1;
-						for( itRange1 = pRange1->begin(); itRange1 != pRange1->end(); itRange1++ )
+						if(counter1>4 && counter1<7 && counter2>4 && counter2<7)
 						{
-							FaultRange *fr1 = (*itRange1);
-							if( frTemp.intersects( fr1 ) ) {
-								// count the intersection
-								n_intersections++;
-								fr1->touched++;
-								break;
-							}
+							if( anyInBank( c1, q.addr, q.mask, ii, CK_CUBE_PAIR_ANY, bank_number1 ) ) n_intersections++;
 						}
-					}
-					if(((counter1>4 && counter1<7) || (counter2>4 && counter2<7))&& (counter1==7 || counter2==7))
-					{
-						list<FaultRange*>::iterator itRange1;
-						for( itRange1 = pRange1->begin(); itRange1 != pRange1->end(); itRange1++ )
+						if(((counter1>4 && counter1<7) || (counter2>4 && counter2<7))&& (counter1==7 || counter2==7))
 						{
-							FaultRange *fr1 = (*itRange1);
-							bank_number2 = getbank_number(*fr1);
-							if(bank_number2==(bank_number1>>1))
-							{
-								if( frTemp.intersects( fr1 ) ) {
-									// count the intersection
-									n_intersections++;
-									fr1->touched++;
-									break;
-								}
-							}
+							if( anyInBank( c1, q.addr, q.mask, ii, CK_CUBE_PAIR_SAME, bank_number1 ) ) n_intersections++;
 						}
+					counter2++;	
 					}
-				counter2++;	
 				}
-			}
-			if( n_intersections > m_n_correct ) 
-			{
-				n_uncorrect = (n_intersections - m_n_correct)+n_uncorrect;
-			}
-			if( n_intersections > m_n_detect ) {
-				n_undetect = (n_intersections - m_n_detect)+n_undetect;
+				if( n_intersections > m_n_correct ) 
+				{
+					n_uncorrect = (n_intersections - m_n_correct)+n_uncorrect;
+				}
+				if( n_intersections > m_n_detect ) {
+					n_undetect = (n_intersections - m_n_detect)+n_undetect;
+				}
+				stride_addr = (stride_addr - stride) & stride;
+			} while( stride_addr != 0 );
+		}
+	}
+}
+
+// Bring the bank buckets up to date with the stores of the module
+
+void ChipKillRepair_cube::updateBanks( FaultDomain *fd )
+{
+	list<FaultDomain*> *pChips = fd->getChildren();
+	list<FaultDomain*>::iterator it;
+
+	m_stores.clear();
+	for( it = pChips->begin(); it != pChips->end(); it++ ) {
+		DRAMDomain *pDRAM = dynamic_cast<DRAMDomain*>((*it));
+		m_stores.push_back( pDRAM->getRanges() );
+	}
+
+	if( fd != m_fd || m_banks.size() != m_stores.size() ) {
+		m_fd = fd;
+		m_banks.resize( m_stores.size() );
+		for( uint32_t c = 0; c < m_banks.size(); c++ ) {
+			m_banks[c].generation = m_stores[c]->getGeneration() + 1;	// forces a rebuild
+			m_banks[c].bucket.resize( banks + 1 );
+		}
+	}
+
+	for( uint32_t c = 0; c < m_stores.size(); c++ ) {
+		FaultStore *pRange = m_stores[c];
+		ChipBanks &chip = m_banks[c];
+
+		// faults were removed and the others moved, start over
+		if( pRange->getGeneration() != chip.generation ) {
+			chip.generation = pRange->getGeneration();
+			chip.known = 0;
+			for( uint32_t b = 0; b <= banks; b++ ) chip.bucket[b].clear();
+		}
+
+		for( ; chip.known < pRange->size(); chip.known++ ) {
+			chip.bucket[getBucket( pRange, chip.known )].push_back( chip.known );
+		}
+	}
+}
+
+// Bucket of a fault: its bank, or banks if any bank bit is wild
+
+uint32_t ChipKillRepair_cube::getBucket( FaultStore *pRange, uint32_t i )
+{
+	uint32_t shift = logRows+logCols+logBits;
+	if( ( pRange->fWildMask[i] >> shift ) & (banks-1) ) return banks;
+	return ( pRange->fAddr[i] >> shift ) & (banks-1);
+}
+
+// The bank pairing rules, on bank numbers as returned by getbank_number
+
+bool ChipKillRepair_cube::pairs( uint32_t pairing, int64_t bank_number1, int64_t bank_number2 )
+{
+	switch( pairing ) {
+	case CK_CUBE_PAIR_LOW:
+		return (bank_number1 !=-1 && bank_number2 !=-1 && bank_number2==(bank_number1>>1))
+			|| ((bank_number1 == -1) && (bank_number2 <4) && (bank_number2>-1))
+			|| (bank_number2 == -1);
+	case CK_CUBE_PAIR_HIGH:
+		return bank_number2==((bank_number1>>1)|0x4);
+	case CK_CUBE_PAIR_SAME:
+		return bank_number2==(bank_number1>>1);
+	}
+	return true;
+}
+
+// A fault with a fixed bank can only intersect a query in its bank, and its bank number is the
+// bucket's, so the bucket of the query's bank is looked at only if that bank pairs. The faults with
+// wild bank bits are checked one by one.
+
+bool ChipKillRepair_cube::anyInBank( uint32_t chip, uint64_t fAddr, uint64_t fWildMask, uint32_t bank, uint32_t pairing, int64_t bank_number1 )
+{
+	FaultStore *pRange1 = m_stores[chip];
+	vector<vector<uint32_t> > &bucket = m_banks[chip].bucket;
+
+	if( pairs( pairing, bank_number1, bank ) ) {
+		vector<uint32_t> &faults = bucket[bank];
+		for( uint32_t k = 0; k < faults.size(); k++ ) {
+			if( pRange1->intersects( faults[k], fAddr, fWildMask ) ) {
+				pRange1->touch( faults[k] );
+				return true;
 			}
 		}
 	}
+
+	vector<uint32_t> &wild = bucket[banks];
+	for( uint32_t k = 0; k < wild.size(); k++ ) {
+		uint32_t i1 = wild[k];
+		if( pRange1->intersects( i1, fAddr, fWildMask )
+				&& pairs( pairing, bank_number1, getbank_number( pRange1->fAddr[i1], pRange1->fWildMask[i1] ) ) ) {
+			pRange1->touch( i1 );
+			return true;
+		}
+	}
+	return false;
 }
 
 void ChipKillRepair_cube::repair_vc(FaultDomain *fd, uint64_t &n_undetect, uint64_t &n_uncorrect)
 {
 }
 
-int64_t ChipKillRepair_cube::getbank_number(FaultRange frTemp )
+int64_t ChipKillRepair_cube::getbank_number( uint64_t fr_fAddr, uint64_t fr_fWildMask )
 {
 		int64_t n_bank_t=0;
 		int64_t n_bankMask_t=0;
-		int64_t fAddr=frTemp.fAddr>>(logRows+logCols+logBits);
-		int64_t fWildMask=frTemp.fWildMask>>(logRows+logCols+logBits);
+		int64_t fAddr=fr_fAddr>>(logRows+logCols+logBits);
+		int64_t fWildMask=fr_fWildMask>>(logRows+logCols+logBits);
 		n_bankMask_t=fWildMask&(banks-1);
 		n_bank_t=fAddr&(banks-1);
 		if(n_bankMask_t==(banks-1))
@@ -260,9 +251,11 @@ int64_t ChipKillRepair_cube::getbank_number(FaultRange frTemp )
 		}
 		return n_bank_t;
 }
-uint64_t ChipKillRepair_cube::fill_repl(FaultDomain *fd)
+// the 8 bytes protected per chip
+
+uint32_t ChipKillRepair_cube::getCodewordBits( void )
 {
-return 0;
+	return 6;
 }
 void ChipKillRepair_cube::printStats( void )
 {
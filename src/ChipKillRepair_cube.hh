@@ -14,6 +14,15 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #define CHIPKILLREPAIR_CUBE_HH_
 
 #include "RepairScheme.hh"
+#include <vector>
+
+// how the bank of an intersecting fault must pair with the bank of the fault under test
+#define CK_CUBE_PAIR_ANY 0	// any bank
+#define CK_CUBE_PAIR_LOW 1	// bank_number1>>1, or wild over all banks
+#define CK_CUBE_PAIR_HIGH 2	// (bank_number1>>1)|0x4
+#define CK_CUBE_PAIR_SAME 3	// bank_number1>>1
+
+class FaultStore;
 
 class ChipKillRepair_cube : public RepairScheme
 {
@@ -21,17 +30,36 @@ public:
 	ChipKillRepair_cube( string name, int n_sym_correct, int n_sym_detect , FaultDomain *fd);
 
 	void repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t &n_uncorrectable );
-	uint64_t fill_repl ( FaultDomain *fd );
+	uint32_t getCodewordBits( void );
 	void printStats( void );
 	void resetStats( void );
 	void clear_counters( void );
 	void repair_hc(FaultDomain *fd, uint64_t &n_undetect, uint64_t &n_uncorrect);
 	void repair_vc(FaultDomain *fd, uint64_t &n_undetect, uint64_t &n_uncorrect);
-	int64_t getbank_number(FaultRange fr_number);
+	int64_t getbank_number( uint64_t fr_fAddr, uint64_t fr_fWildMask );
 private:
+	// The faults of a chip bucketed by bank, kept across repair() calls and extended with the
+	// faults inserted since the previous one (rebuilt when the store removes faults)
+	struct ChipBanks
+	{
+		uint64_t generation;	// FaultStore generation the buckets refer to
+		uint32_t known;	// faults [0, known) are bucketed
+		vector<vector<uint32_t> > bucket;	// per bank the faults with a fixed bank, then those with wild bank bits
+	};
+
+	void updateBanks( FaultDomain *fd );
+	uint32_t getBucket( FaultStore *pRange, uint32_t i );
+	bool pairs( uint32_t pairing, int64_t bank_number1, int64_t bank_number2 );
+	// whether a fault of the chip in a bank that pairs intersects the query, which is in the given bank
+	bool anyInBank( uint32_t chip, uint64_t fAddr, uint64_t fWildMask, uint32_t bank, uint32_t pairing, int64_t bank_number1 );
+
 	uint64_t m_n_correct, m_n_detect;
 	uint64_t counter_prev, counter_now;
 	uint32_t logBits, logCols, logRows, banks;
+
+	FaultDomain *m_fd;	// module the buckets belong to
+	vector<FaultStore*> m_stores;	// of the chips of the module, in order
+	vector<ChipBanks> m_banks;
 };
 
 
@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "CodewordLayout.hh"
+#include <iostream>
+
+static const CodewordLayout layouts[] = {
+	// name			device	symbol	codeword	chips	correct	detect
+	// binary BCH over 4, 16 and 32 locations of every chip
+	{ "SECDED",		0,	0,	2,	0,	1,	2 },
+	{ "3EC4ED",		0,	0,	4,	0,	3,	4 },
+	{ "6EC7ED",		0,	0,	5,	0,	6,	7 },
+	// ChipKill over 18 (36 for double ChipKill) x4 chips, 8-bit symbols of two beats
+	{ "CK1",		4,	3,	3,	18,	1,	2 },
+	{ "CK2",		4,	3,	3,	36,	2,	4 },
+	// DDR4 single symbol correct, one 8- or 16-bit symbol per beat of a burst of 8
+	{ "X8_SSC",		8,	3,	6,	9,	1,	2 },
+	{ "X16_SSC",	16,	4,	7,	5,	1,	2 },
+	// DDR5 40-bit sub-channel, burst of 16: ChipKill over 10 x4 chips, or 8-bit symbols on 5 x8 chips
+	{ "DDR5_X4",	4,	6,	6,	10,	1,	2 },
+	{ "DDR5_X8",	8,	3,	7,	5,	1,	2 },
+};
+
+static const uint32_t n_layouts = sizeof( layouts ) / sizeof( layouts[0] );
+
+uint32_t CodewordLayout::getSymbolsPerChip( void ) const
+{
+	return 1 << ( log_codeword - log_symbol );
+}
+
+const CodewordLayout *CodewordLayout::find( const string &name )
+{
+	for( uint32_t i = 0; i < n_layouts; i++ ) {
+		if( name == layouts[i].name ) return &layouts[i];
+	}
+
+	return NULL;
+}
+
+void CodewordLayout::printLayouts( void )
+{
+	for( uint32_t i = 0; i < n_layouts; i++ ) {
+		const CodewordLayout &l = layouts[i];
+		cout << "# " << l.name << ": " << l.getSymbolsPerChip() << " symbol(s) of " << (1 << l.log_symbol)
+		     << " bit(s) per chip, " << l.chips << " chips, correct " << l.n_correct << " detect " << l.n_detect << "\n";
+	}
+}
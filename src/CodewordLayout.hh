@@ -0,0 +1,47 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CODEWORDLAYOUT_HH_
+#define CODEWORDLAYOUT_HH_
+
+#include "boost/cstdint.hpp"
+#include <string>
+
+using namespace std;
+
+// Describes how a symbol-based ECC code lays its codewords out over the chips of a module, in
+// terms of chip locations (one location is one bit of one chip; the lowest address bits select
+// the bit of the device width, the next ones the column, so consecutive locations are the bits
+// of consecutive beats of a burst).
+//
+// Each chip holds an aligned block of 2^log_codeword locations of a codeword, split into aligned
+// symbols of 2^log_symbol locations. The code corrects n_correct and detects n_detect faulty
+// symbols. Binary BCH codes have one-bit symbols, ChipKill codes one symbol per chip.
+
+class CodewordLayout
+{
+	public:
+	const char *name;
+	uint32_t device_bits;	// chip width the layout is meant for, 0 for any
+	uint32_t log_symbol;	// log2 of the locations of a chip in one symbol
+	uint32_t log_codeword;	// log2 of the locations of a chip in one codeword
+	uint32_t chips;	// chips of the module the codewords span, 0 for any number
+	uint32_t n_correct, n_detect;	// in symbols
+
+	uint32_t getSymbolsPerChip( void ) const;
+
+	// layout with the given name, or NULL
+	static const CodewordLayout *find( const string &name );
+	static void printLayouts( void );
+};
+
+#endif /* CODEWORDLAYOUT_HH_ */
@@ -18,6 +18,7 @@ extern struct Settings settings;
 #include <stdio.h>
 #include <string.h>
 #include "Settings.hh"
+#include "faultsim.hh"
 #include <stdint.h>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/ini_parser.hpp>
@@ -27,7 +28,16 @@ void parser(char *ininame)
 	boost::property_tree::ptree pt;
 	boost::property_tree::ini_parser::read_ini( ininame, pt );
 
-	settings.sim_mode = pt.get<int>("Sim.sim_mode");
+	std::string sim_mode = pt.get<std::string>("Sim.sim_mode");
+	if( sim_mode == "1" ) {
+		settings.sim_mode = SIM_INTERVAL;
+	} else if( sim_mode == "2" ) {
+		settings.sim_mode = SIM_EVENT;
+	} else if( sim_mode == "auto" ) {
+		settings.sim_mode = SIM_AUTO;
+	} else {
+		settings.sim_mode = SIM_INVALID;
+	}
 	settings.interval_s = pt.get<uint64_t>("Sim.interval_s");
 	settings.scrub_s = pt.get<uint64_t>("Sim.scrub_s");
 	settings.max_s = pt.get<uint64_t>("Sim.max_s");
@@ -36,8 +46,10 @@ void parser(char *ininame)
 	settings.verbose = pt.get<int>("Sim.verbose");
 	settings.debug = pt.get<int>("Sim.debug");
 	settings.output_bucket_s = pt.get<uint64_t>("Sim.output_bucket_s");
+	settings.huge_pages = pt.get<bool>("Sim.huge_pages", false);
 
 	settings.organization = pt.get<int>("Org.organization");
+	settings.modules = pt.get<int>("Org.modules", 1);
 	settings.chips_per_rank = pt.get<int>("Org.chips_per_rank");
 	settings.chip_bus_bits = pt.get<int>("Org.chip_bus_bits");
 	settings.ranks = pt.get<int>("Org.ranks");
@@ -57,5 +69,22 @@ void parser(char *ininame)
 	settings.fit_factor = pt.get<double>("Fault.fit_factor");
 	settings.tsv_fit = pt.get<double>("Fault.tsv_fit");
 
+	// Optional FIT profiles. Profile.transient and Profile.permanent apply to all fault
+	// classes, and e.g. Profile.permanent_1row overrides them for a single class.
+	const char *class_names[DRAM_MAX] = { "1bit", "1word", "1col", "1row", "1bank", "nbank", "nrank" };
+	std::string transient_all = pt.get<std::string>("Profile.transient", "");
+	std::string permanent_all = pt.get<std::string>("Profile.permanent", "");
+
+	for( int i = 0; i < DRAM_MAX; i++ ) {
+		settings.transient_profile[i] = pt.get<std::string>( std::string("Profile.transient_") + class_names[i], transient_all );
+		settings.permanent_profile[i] = pt.get<std::string>( std::string("Profile.permanent_") + class_names[i], permanent_all );
+	}
+
 	settings.repairmode = pt.get<int>("ECC.repairmode");
+	settings.ecc_layout = pt.get<std::string>("ECC.layout", "");
+	settings.ondie_sec_bits = pt.get<int>("ECC.ondie_sec_bits", 0);
+	settings.spare_rows = pt.get<int>("ECC.spare_rows", 0);
+	settings.spare_cols = pt.get<int>("ECC.spare_cols", 0);
+	settings.spare_banks = pt.get<int>("ECC.spare_banks", 0);
+	settings.spare_chips = pt.get<int>("ECC.spare_chips", 0);
 }
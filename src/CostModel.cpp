@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "CostModel.hh"
+#include "faultsim.hh"
+#include "GroupDomain.hh"
+#include "DRAMDomain.hh"
+#include "FITProfile.hh"
+#include <iostream>
+#include <stdio.h>
+#include <math.h>
+
+// Repair cost per call, per call per live DRAM fault range and per call per live TSV fault range,
+// indexed by repairmode. Calibrated together with the COST_ constants by a least squares fit of the
+// relative error of intervalCost() and eventCost() against measured CPU time per simulation, for
+// every repairmode of the shipped DIMM_ChipKill and 3D_SECDED configs (ChipKill also with 36 chips,
+// symbol codes with the CK1 layout), in both simulators, at fit_factor 1 to 1000 (1 to 100 for 3D
+// stacks), and with tsv_fit 10^4 and 10^5 for the TSV costs. With repair, the fit is within 30% of
+// the measured time, and selects the faster simulator for every one of these configs.
+static const double dimm_call_cost[7]      = { 0, 1.95, 3.55, 1.67, 1.82, 1.32, 1.96 };	// none, ChipKill, BCH, any symbol code
+static const double dimm_range_cost[7]     = { 0, 0.0025, 0.0085, 0.0084, 0, 0, 0.12 };
+static const double cube_call_cost[7]      = { 0, 1.70, 1.96, 2.94, 2.81, 3.09, 0 };	// none, ChipKill, RAID, BCH
+static const double cube_range_cost[7]     = { 0, 0, 0, 0, 0.92, 0.40, 0 };
+static const double cube_tsv_range_cost[7] = { 0, 0.70, 0.49, 0.48, 0.32, 0.26, 0 };
+
+CostModel::CostModel( list<GroupDomain*> &modules, uint64_t max_s, uint64_t interval_s, double fit_factor,
+		uint test_mode_t, int organization, int repairmode )
+{
+	double max_hours = max_s / ( 60.0 * 60.0 );
+
+	n_modules = modules.size();
+	n_chips = 0;
+	n_iterations = max_s / interval_s;
+	n_faults = 0;
+	n_ranges = 0;
+	n_tsv_faults = 0;
+	n_tsv_ranges = 0;
+	has_profiles = false;
+	test_mode = test_mode_t;
+
+	// 1 FIT = 1 fault in 10^9 device-hours
+	for( list<GroupDomain*>::iterator it = modules.begin(); it != modules.end(); it++ ) {
+		list<FaultDomain*> *pChips = (*it)->getChildren();
+
+		for( list<FaultDomain*>::iterator it1 = pChips->begin(); it1 != pChips->end(); it1++ ) {
+			DRAMDomain *pD = (DRAMDomain*)(*it1);
+			n_chips++;
+
+			for( int i = 0; i < DRAM_MAX*2; i++ ) {
+				double FIT = ( i < DRAM_MAX ) ? pD->transientFIT[i] : pD->permanentFIT[i-DRAM_MAX];
+				double factor = 1;
+
+				if( pD->fit_profile[i] != NULL ) {
+					has_profiles = true;
+					factor = pD->fit_profile[i]->average( max_hours );
+				}
+
+				n_faults += FIT * factor * fit_factor * max_hours / 1000000000.0;
+			}
+		}
+
+		// A failed data TSV turns into a single strided fault range, or one range per bit it carries
+		// when the number of data TSVs is not a power of two
+		if( (*it)->cube_model_enable > 0 && (*it)->enable_tsv ) {
+			DRAMDomain *pD = (DRAMDomain*)pChips->front();
+			double tsv_faults = ( (*it)->tsv_transientFIT + (*it)->tsv_permanentFIT ) * fit_factor * max_hours / 1000000000.0;
+			double data_tsv = (double)( (*it)->cube_data_tsv * ( (*it)->tsv_shared_accross_chips ? (*it)->banks : (*it)->chips ) );
+			double ranges_per_data_tsv = 1;
+			if( ((*it)->cube_data_tsv & ((*it)->cube_data_tsv-1)) != 0 ) {
+				ranges_per_data_tsv = (double)( pD->getCols() * pD->getBits() ) / (*it)->cube_data_tsv;
+			}
+
+			n_tsv_faults += tsv_faults;
+			n_tsv_ranges += tsv_faults * ( data_tsv / (*it)->total_tsv ) * ranges_per_data_tsv;
+		}
+	}
+
+	n_ranges = n_faults + n_tsv_ranges;
+	n_faults += n_tsv_faults;
+
+	if( repairmode < 0 || repairmode > 6 ) repairmode = 0;
+
+	if( organization == MO_3D ) {
+		n_stacks = n_modules;
+		repair_call_cost = cube_call_cost[repairmode];
+		repair_range_cost = cube_range_cost[repairmode];
+		repair_tsv_range_cost = cube_tsv_range_cost[repairmode];
+	} else {
+		n_stacks = 0;
+		repair_call_cost = dimm_call_cost[repairmode];
+		repair_range_cost = dimm_range_cost[repairmode];
+		repair_tsv_range_cost = 0;
+	}
+}
+
+// Fault ranges accumulate over a simulation, so a repair call sees half of them on average
+
+double CostModel::repairCost( double calls )
+{
+	double live_ranges = ( n_ranges - n_tsv_ranges ) / n_modules / 2;
+	double live_tsv_ranges = n_tsv_ranges / n_modules / 2;
+	return calls * ( repair_call_cost + repair_range_cost * live_ranges + repair_tsv_range_cost * live_tsv_ranges );
+}
+
+double CostModel::intervalCost( void )
+{
+	// expected number of intervals holding at least one fault, in the system and per module
+	double steps, module_steps;
+
+	if( test_mode != 0 ) {
+		steps = module_steps = n_iterations;
+	} else {
+		steps = n_iterations * ( 1 - exp( -n_faults / n_iterations ) );
+		module_steps = n_iterations * ( 1 - exp( -n_faults / n_modules / n_iterations ) );
+	}
+
+	return n_chips * COST_CHIP_INTERVAL + n_stacks * COST_STACK_INTERVAL + steps * n_chips * COST_CHIP_STEP
+			+ n_faults * COST_FAULT + n_tsv_faults * COST_TSV_FAULT + repairCost( module_steps * n_modules );
+}
+
+double CostModel::eventCost( void )
+{
+	return n_chips * COST_CHIP_EVENT + n_stacks * COST_STACK_EVENT + n_faults * COST_FAULT + n_tsv_faults * COST_TSV_FAULT
+			+ repairCost( n_faults );
+}
+
+int CostModel::selectMode( void )
+{
+	if( has_profiles ) return SIM_EVENT;
+	if( test_mode != 0 ) return SIM_INTERVAL;
+
+	return ( intervalCost() < eventCost() ) ? SIM_INTERVAL : SIM_EVENT;
+}
+
+void CostModel::printEstimate( uint64_t n_sims )
+{
+	cout << "# -------------------------------------------------------------------\n";
+	cout << "# Cost estimate\n";
+	cout << "# modules " << n_modules << " chips " << n_chips << " intervals " << n_iterations << "\n";
+	cout << "# expected faults per simulation " << n_faults << " (TSV " << n_tsv_faults << ") fault ranges " << n_ranges << "\n";
+
+	if( has_profiles ) {
+		cout << "# interval-based: not supported (FIT profiles)\n";
+	} else {
+		printf( "# interval-based: %.2f us per simulation, %.1f s for %lu simulations\n", intervalCost(), intervalCost() * n_sims / 1000000.0, (unsigned long)n_sims );
+	}
+
+	if( test_mode != 0 ) {
+		cout << "# event-driven: not supported (test mode)\n";
+	} else {
+		printf( "# event-driven: %.2f us per simulation, %.1f s for %lu simulations\n", eventCost(), eventCost() * n_sims / 1000000.0, (unsigned long)n_sims );
+	}
+
+	cout << "# selected: " << ( ( selectMode() == SIM_INTERVAL ) ? "interval-based" : "event-driven" ) << "\n";
+	cout << "# -------------------------------------------------------------------\n";
+}
@@ -0,0 +1,66 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef COSTMODEL_HH_
+#define COSTMODEL_HH_
+
+#include "dram_common.hh"
+#include <list>
+
+class GroupDomain;
+
+using namespace std;
+
+// Measured costs in microseconds (x86-64, 3 GHz class core), see CostModel.cpp for the calibration
+#define COST_CHIP_EVENT      0.06	// per DRAM per event-driven simulation: reset and first fault arrival
+#define COST_CHIP_INTERVAL   0.55	// per DRAM per interval-based simulation: reset and first fault intervals
+#define COST_CHIP_STEP       0.031	// per DRAM per simulated interval holding a fault
+#define COST_STACK_EVENT     1.7	// per 3D stack per event-driven simulation: TSV state reset
+#define COST_STACK_INTERVAL  4.0	// per 3D stack per interval-based simulation: TSV state reset and updates
+#define COST_FAULT           0.14	// per fault: range generation and event handling
+#define COST_TSV_FAULT       0.52	// per TSV fault: expansion into fault ranges in every DRAM
+
+// Predicts the run time of the interval-based and the event-driven simulator for a
+// memory organization, before the modules are initialized. Both simulators spend most
+// of their time in repair, which is called once per fault event by the event-driven
+// simulator, but only once per interval holding faults by the interval-based one.
+// The interval-based simulator also visits every DRAM in every such interval.
+
+class CostModel
+{
+	public:
+	CostModel( list<GroupDomain*> &modules, uint64_t max_s, uint64_t interval_s, double fit_factor,
+			uint test_mode, int organization, int repairmode );
+
+	double intervalCost( void );	// predicted microseconds per simulation
+	double eventCost( void );
+	int selectMode( void );	// the cheaper simulator that supports the configuration
+	void printEstimate( uint64_t n_sims );
+
+	protected:
+	double repairCost( double calls );
+
+	uint64_t n_modules, n_chips;
+	uint64_t n_stacks;		// modules that are 3D stacks
+	double n_iterations;	// simulated intervals
+	double n_faults;		// expected fault events per simulation (DRAM and TSV)
+	double n_ranges;		// expected fault ranges inserted per simulation
+	double n_tsv_faults;
+	double n_tsv_ranges;	// TSV fault ranges span whole rows, which makes them more costly to repair
+	bool has_profiles;		// some FIT rate varies with age, requires the event-driven simulator
+	uint test_mode;			// test modes insert faults in every interval, requires the interval-based simulator
+	double repair_call_cost, repair_range_cost;	// repair cost per call, and per call per live range
+	double repair_tsv_range_cost;	// repair cost per call per live TSV fault range
+};
+
+
+#endif /* COSTMODEL_HH_ */
@@ -13,6 +13,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "CubeRAIDRepair.hh"
 #include "DRAMDomain.hh"
 #include "Settings.hh"
+#include <algorithm>
 
 extern struct Settings settings;
 
@@ -38,13 +39,7 @@ void CubeRAIDRepair::repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t
 	for( it1 = pChips->begin(); it1 != pChips->end(); it1++ )
 	{
 		DRAMDomain *pDRAM1 = dynamic_cast<DRAMDomain*>((*it1));
-		list<FaultRange*> *pRange3 = pDRAM1->getRanges();
-		list<FaultRange*>::iterator itRange3;
-		for( itRange3 = pRange3->begin(); itRange3 != pRange3->end(); itRange3++ )
-		{
-			FaultRange *fr3 = (*itRange3);
-			fr3->touched=0;
-		}
+		pDRAM1->getRanges()->clearTouched();
 	}
 	// Take each chip in turn.  For every fault range,
 	// count the number of intersecting faults.
@@ -53,75 +48,71 @@ void CubeRAIDRepair::repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t
 	{
 
 		DRAMDomain *pDRAM0 = dynamic_cast<DRAMDomain*>((*it0));
-		list<FaultRange*> *pRange0 = pDRAM0->getRanges();
+		FaultStore *pRange0 = pDRAM0->getRanges();
 
 		// For each fault in first chip, query the other chips to see if they have
 		// an intersecting fault range.
-		list<FaultRange*>::iterator itRange0;
-		for( itRange0 = pRange0->begin(); itRange0 != pRange0->end(); itRange0++ )
+		for( uint32_t i0 = 0; i0 < pRange0->size(); i0++ )
 		{
-			// Make a copy, otherwise fault is modified as a side-effect
-			FaultRange *frOrg = (*itRange0); // The pointer to the fault location
-			FaultRange frTemp = *(*itRange0);
-
-			// round the FR size to that of a detection block (e.g. cache line)
-			frTemp.fWildMask |= ((1 << m_log_block_bits)-1);
-
-			uint32_t n_intersections = 0;
-			if(frTemp.touched<frTemp.max_faults)
-			{
-				// for each other chip, count number of intersecting faults
-				//it1 = it0;
-				//it1++;
-				for( it1 = pChips->begin(); it1 != pChips->end(); it1++ )
+			// a TSV fault is checked one block of its stride at a time, as if each were a separate fault
+			uint64_t stride = pRange0->getTSVStride( i0, m_log_block_bits );
+			uint64_t stride_addr = 0;
+			do {
+				// round the FR size to that of a detection block (e.g. cache line)
+				FaultQuery q = pRange0->getQuery( i0 );
+				q.addr |= stride_addr;
+				q.mask = (q.mask & ~stride) | ((1 << m_log_block_bits)-1);
+
+				uint32_t n_intersections = 0;
+				if(pRange0->untouched( i0 ))
 				{
-					if( it0 == it1 ) continue;	// skip if we're looking at the first chip
-
-					DRAMDomain *pDRAM1 = dynamic_cast<DRAMDomain*>((*it1));
-					list<FaultRange*> *pRange1 = pDRAM1->getRanges();
-					list<FaultRange*>::iterator itRange1;
-					for( itRange1 = pRange1->begin(); itRange1 != pRange1->end(); itRange1++ )
+					// for each other chip, count number of intersecting faults, until the
+					// verdict is settled; the faults are never touched, so a chip with a fault
+					// covering whole banks meets the query without a search
+					//it1 = it0;
+					//it1++;
+					for( it1 = pChips->begin(); it1 != pChips->end() && n_intersections < max( m_n_correct, m_n_detect ); it1++ )
 					{
-						FaultRange frTemp1 = *(*itRange1);
-
-						// round the FR size to that of a detection block (e.g. cache line)
-						frTemp1.fWildMask |= ((1 << m_log_block_bits)-1);
-
-						if(frTemp1.touched < frTemp1.max_faults)
-						{	
-							if(frTemp.intersects(&frTemp1)) {
-								// count the intersection
-								n_intersections++;
-								break;
-							}
+						if( it0 == it1 ) continue;	// skip if we're looking at the first chip
+
+						DRAMDomain *pDRAM1 = dynamic_cast<DRAMDomain*>((*it1));
+						FaultStore *pRange1 = pDRAM1->getRanges();
+						// the block bits are already wild in the query, so the other
+						// chip's ranges need not be rounded as well
+						if( pRange1->anyBankWide( q.addr, q.mask ) || pRange1->anyIntersecting( q, true ) ) {
+							// count the intersection
+							n_intersections++;
 						}
 					}
 				}
-			}
-
-			// 1 intersection implies 2 overlapping faults
-			if(n_intersections < m_n_correct)
-			{
-				// correctable
-			}
-			if( n_intersections >= m_n_correct)
-			{
-				// uncorrectable fault discovered
-				n_uncorrectable += (n_intersections + 1 - m_n_correct);
-				frOrg->transient_remove = false;
-
-				if( !settings.continue_running ) return;
-			}
-			if( n_intersections >= m_n_detect) {
-				n_undetectable += (n_intersections + 1 - m_n_detect);
-			}
+
+				// 1 intersection implies 2 overlapping faults
+				if(n_intersections < m_n_correct)
+				{
+					// correctable
+				}
+				if( n_intersections >= m_n_correct)
+				{
+					// uncorrectable fault discovered
+					n_uncorrectable += (n_intersections + 1 - m_n_correct);
+					pRange0->transient_remove[i0] = false;
+
+					if( !settings.continue_running ) return;
+				}
+				if( n_intersections >= m_n_detect) {
+					n_undetectable += (n_intersections + 1 - m_n_detect);
+				}
+				stride_addr = (stride_addr - stride) & stride;
+			} while( stride_addr != 0 );
 		}
 	}
 }
 
-uint64_t CubeRAIDRepair::fill_repl(FaultDomain *fd)
+// one detection block
+
+uint32_t CubeRAIDRepair::getCodewordBits( void )
 {
-	return 0;
+	return m_log_block_bits;
 }
 void CubeRAIDRepair::printStats( void )
 {
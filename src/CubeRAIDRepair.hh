@@ -21,7 +21,7 @@ public:
 	CubeRAIDRepair( string name, uint n_sym_correct, uint n_sym_detect, uint detect_block_bytes );
 
 	void repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t &n_uncorrectable );
-	uint64_t fill_repl ( FaultDomain *fd );
+	uint32_t getCodewordBits( void );
 	void printStats( void );
 	void resetStats( void );
 	void clear_counters( void );
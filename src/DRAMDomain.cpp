@@ -18,10 +18,13 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include <sys/time.h>
 #include "faultsim.hh"
 #include "Settings.hh"
+#include "FITProfile.hh"
 
 extern struct Settings settings;
 
 DRAMDomain::DRAMDomain( char *name, uint32_t n_bitwidth, uint32_t n_ranks, uint32_t n_banks, uint32_t n_rows, uint32_t n_cols ) : FaultDomain( name )
+, m_faultRanges( this )
+, m_onDieRanges( this )
 , dist(0,1)
 , gen(eng,dist)
 , m_bitwidth( n_bitwidth )
@@ -45,7 +48,15 @@ DRAMDomain::DRAMDomain( char *name, uint32_t n_bitwidth, uint32_t n_ranks, uint3
 		permanentFIT[i] = 0;
 	}
 
+	for( int i = 0; i < DRAM_MAX*2; i++ ) {
+		fit_profile[i] = NULL;
+		m_constantRate[i] = 0;
+	}
+
 	n_faults_transient_tsv = n_faults_permanent_tsv = 0;
+	n_ondie_corrected = n_ondie_promoted = n_ondie_miscorrected = 0;
+	m_onDieBits = 0;
+	m_onDieMiscorrect = 0;
 
 	m_logRanks = log2( m_ranks );
 	m_logBanks = log2( m_banks );
@@ -53,7 +64,14 @@ DRAMDomain::DRAMDomain( char *name, uint32_t n_bitwidth, uint32_t n_ranks, uint3
 	m_logCols = log2( m_cols );
 	m_logBits = log2( m_bitwidth );
 
-	curr_interval = 0;
+	// index faults by rank/bank/row and by rank/bank
+	m_faultRanges.setKeyShifts( m_logCols + m_logBits, m_logRows + m_logCols + m_logBits,
+			m_logBanks + m_logRows + m_logCols + m_logBits, m_logRanks + m_logBanks + m_logRows + m_logCols + m_logBits );
+	m_onDieRanges.setKeyShifts( m_logCols + m_logBits, m_logRows + m_logCols + m_logBits,
+			m_logBanks + m_logRows + m_logCols + m_logBits, m_logRanks + m_logBanks + m_logRows + m_logCols + m_logBits );
+
+	n_transient_ranges = 0;
+	next_fault_valid = false;
 
 	if( settings.verbose )
 	{
@@ -71,11 +89,107 @@ DRAMDomain::DRAMDomain( char *name, uint32_t n_bitwidth, uint32_t n_ranks, uint3
 	}
 }
 
-list<FaultRange*> *DRAMDomain::getRanges( void )
+FaultStore *DRAMDomain::getRanges( void )
 {
 	return &m_faultRanges;
 }
 
+FaultStore *DRAMDomain::getOnDieRanges( void )
+{
+	return &m_onDieRanges;
+}
+
+void DRAMDomain::addCodewordBits( uint32_t bits )
+{
+	m_faultRanges.setWordBits( bits );
+}
+
+// A Hamming SEC code over k data bits needs r check bits with 2^r >= k + r + 1. A double-bit error
+// has a non-zero syndrome that the decoder takes for a single-bit error; for about (k - 2) of the
+// 2^r - 1 syndromes that is a third data bit, which it then flips.
+
+void DRAMDomain::setOnDieECC( uint32_t data_bits )
+{
+	m_onDieBits = log2( data_bits );
+	assert( ( 1U << m_onDieBits ) == data_bits && m_onDieBits <= m_logCols + m_logBits );
+
+	uint32_t r = 1;
+	while( ( 1ULL << r ) < (uint64_t)data_bits + r + 1 ) r++;
+	m_onDieMiscorrect = data_bits > 2 ? (double)( data_bits - 2 ) / ( ( 1ULL << r ) - 1 ) : 0;
+
+	m_onDieRanges.setWordBits( m_onDieBits );
+}
+
+void DRAMDomain::insertRange( FaultRange *fr )
+{
+	if( fr->transient ) n_transient_ranges++;
+
+	if( m_onDieBits == 0 ) {
+		m_faultRanges.insert( fr );
+	} else {
+		insertOnDie( fr );
+	}
+}
+
+// With on-die ECC, a fault that puts at most one faulty bit in each of its codewords, and shares
+// none of them with another fault, is corrected inside the chip and kept out of the module-level
+// repair. Once a codeword holds more faulty bits, all faults in it reach the module, and two
+// single-bit faults may be miscorrected into a third faulty bit. The faults corrected on-die are
+// promoted as a whole, even if they only share some of their codewords with the new fault. A failed
+// TSV takes out the bit lane on every access, outside the arrays the on-die code protects, so TSV
+// faults always go to the module.
+
+void DRAMDomain::insertOnDie( FaultRange *fr )
+{
+	uint64_t word = ( 1ULL << m_onDieBits ) - 1;
+	uint64_t addr = fr->fAddr & ~word;
+	uint64_t mask = fr->fWildMask | word;
+	bool single = !fr->TSV && ( fr->fWildMask & word ) == 0;
+
+	m_onDieHits.clear();
+	m_onDieRanges.collectIntersecting( addr, mask, m_onDieHits );
+
+	if( single && m_onDieHits.empty() && !m_faultRanges.anyIntersecting( addr, mask, false ) ) {
+		m_onDieRanges.insert( fr );
+		n_ondie_corrected++;
+		return;
+	}
+
+	for( uint32_t h = 0; h < m_onDieHits.size(); h++ ) {
+		FaultRange other = m_onDieRanges.get( m_onDieHits[h] );
+		m_faultRanges.insert( &other );
+		n_ondie_promoted++;
+
+		if( single && gen() < m_onDieMiscorrect ) {
+			// a random bit of the codewords both faults are in; it is only wrong while both are
+			FaultRange mis( this );
+			mis.fWildMask = fr->fWildMask & other.fWildMask;
+			mis.fAddr = ( ( fr->fAddr & ~fr->fWildMask ) | ( other.fAddr & ~other.fWildMask ) ) & ~word;
+			mis.fAddr |= eng32() & word;
+			mis.max_faults = 1ULL << __builtin_popcountll( mis.fWildMask );
+			mis.transient = fr->transient || other.transient;
+			mis.timestamp = fr->timestamp;
+			m_faultRanges.insert( &mis );
+			if( mis.transient ) n_transient_ranges++;
+			n_ondie_miscorrected++;
+		}
+	}
+	m_onDieRanges.remove( m_onDieHits );
+
+	m_faultRanges.insert( fr );
+}
+
+void DRAMDomain::retireRanges( const vector<uint32_t> &indices )
+{
+	// only permanent faults are spared, n_transient_ranges is unchanged
+	m_faultRanges.remove( indices );
+}
+
+uint64_t DRAMDomain::getTransientRangeCount( void )
+{
+	return n_transient_ranges + FaultDomain::getTransientRangeCount();
+}
+
 const char *DRAMDomain::faultClassString( int i )
 {
 	switch( i ) {
@@ -120,25 +234,28 @@ int DRAMDomain::update( uint test_mode_t )
 	int newfault1 = 0;
 	newfault0 = FaultDomain::update(test_mode_t); 
 
+	if( !next_fault_valid ) drawNextFaults();
+
 	// Insert DRAM die faults
 	for( uint i = 0; i < DRAM_MAX; i++ ) {
 		if(test_mode_t==0)
 		{
-			double random = gen();
-			if( random <= transientFIT[i] ) {
+			// Rather than drawing a uniform random number per interval, the interval of the
+			// next fault in each class was drawn from the equivalent geometric distribution
+			if( next_fault_interval[i] == curr_interval ) {
 				n_faults_transient++;
 				n_faults_transient_class[i]++;
 				generateRanges( i, true );
 				newfault1 = 1;			
+				next_fault_interval[i] = geometricNext( curr_interval + 1, gen(), transientFIT[i] );
 			}
 
-			random = gen();
-
-			if( random <= permanentFIT[i] ) {
+			if( next_fault_interval[i+DRAM_MAX] == curr_interval ) {
 				n_faults_permanent++;
 				n_faults_permanent_class[i]++;
 				generateRanges( i, false );
 				newfault1 = 1;
+				next_fault_interval[i+DRAM_MAX] = geometricNext( curr_interval + 1, gen(), permanentFIT[i] );
 			}
 
 		}
@@ -161,6 +278,96 @@ int DRAMDomain::update( uint test_mode_t )
 	}
 
 	// Insert TSV faults
+	if( updateTSV() ) {
+		newfault1 = 1;
+	}
+
+	curr_interval++;
+	
+	return (newfault0 || newfault1);
+}
+
+// Draw the next fault arrival of a fault type for the event-driven simulator. Arrivals with an
+// age-dependent FIT rate are sampled exactly by thinning: candidates are drawn at an upper bound
+// of the rate over the rest of the simulation and accepted with probability rate / bound.
+
+double DRAMDomain::nextFaultTime( int faultType, double time_s, double max_s )
+{
+	double sec_per_hour = 60 * 60;
+
+	if( fit_profile[faultType] == NULL ) {
+		return time_s + -1*log(gen())*hrs_per_fault[faultType] * sec_per_hour; //Exponential interval in SECONDS
+	}
+
+	double hours = time_s / sec_per_hour;
+	double max_hours = max_s / sec_per_hour;
+
+	while( 1 ) {
+		double bound = fit_profile[faultType]->bound( hours, max_hours );
+		if( bound <= 0 ) return HUGE_VAL;
+
+		hours += -1*log(gen())*hrs_per_fault[faultType] / bound;
+		if( hours > max_hours ) return hours * sec_per_hour;
+
+		if( gen() * bound <= fit_profile[faultType]->multiplier( hours ) ) return hours * sec_per_hour;
+	}
+}
+
+// The fault types with a constant FIT rate are independent Poisson processes, so together they are
+// one Poisson process of the summed rate, and each of its arrivals is of a type drawn in proportion
+// to the rates. A chip then needs one draw per simulation, rather than one per fault type, to find
+// that none of them fails, which is by far the most common outcome.
+
+double DRAMDomain::nextConstantFaultTime( double time_s )
+{
+	double rate = m_constantRate[DRAM_MAX*2-1];
+	if( rate == 0 ) return HUGE_VAL;
+
+	return time_s + -1*log(gen()) / rate * ( 60 * 60 ); //Exponential interval in SECONDS
+}
+
+int DRAMDomain::drawConstantFaultType( void )
+{
+	double r = gen() * m_constantRate[DRAM_MAX*2-1];
+
+	// the first type whose running sum exceeds r has a rate of its own; should r round up to the
+	// total, take the last type that has one
+	int i = 0;
+	while( i < DRAM_MAX*2-1 && m_constantRate[i] <= r ) i++;
+	while( i > 0 && m_constantRate[i] == m_constantRate[i-1] ) i--;
+	return i;
+}
+
+uint64_t DRAMDomain::getNextFaultInterval( void )
+{
+	if( !next_fault_valid ) drawNextFaults();
+
+	uint64_t next = FaultDomain::getNextFaultInterval();
+	for( int i = 0; i < DRAM_MAX*2; i++ ) {
+		if( next_fault_interval[i] < next ) next = next_fault_interval[i];
+	}
+
+	return next;
+}
+
+// Draw the first fault interval of every fault class for a new simulation
+
+void DRAMDomain::drawNextFaults( void )
+{
+	for( int i = 0; i < DRAM_MAX; i++ ) {
+		next_fault_interval[i] = geometricNext( curr_interval, gen(), transientFIT[i] );
+		next_fault_interval[i+DRAM_MAX] = geometricNext( curr_interval, gen(), permanentFIT[i] );
+	}
+
+	next_fault_valid = true;
+}
+
+// Expand any newly failed TSVs belonging to this chip into FaultRanges
+
+int DRAMDomain::updateTSV( void )
+{
+	int newfault1 = 0;
+
 	if((cube_model_enable>0) && enable_tsv)
 	{
 		for(uint ii=(children_counter*cube_data_tsv); ii<((children_counter+1)*cube_data_tsv); ii++ )
@@ -173,11 +380,7 @@ int DRAMDomain::update( uint test_mode_t )
 					n_faults_permanent_tsv++;
 					newfault1 = 1;
 
-					for(uint jj=0; jj<(m_cols*m_bitwidth/cube_data_tsv); jj++ )
-					{
-						m_faultRanges.push_back( genRandomRange( 0, 0, 0, 1, 1, false, (ii%cube_data_tsv)+(jj*cube_data_tsv), true ) );
-						//cout << "|" <<(ii%cube_data_tsv)+(jj*cube_data_tsv)<< "|";
-					}
+					insertTSVRanges( ii%cube_data_tsv, false );
 					tsv_info[ii]=3;
 				}
 				else if (tsv_info[ii]==2)
@@ -186,20 +389,35 @@ int DRAMDomain::update( uint test_mode_t )
 					n_faults_transient_tsv++;
 					newfault1 = 1;
 
-					for(uint jj=0; jj<(m_cols*m_bitwidth/cube_data_tsv); jj++ )
-					{
-						m_faultRanges.push_back( genRandomRange( 0, 0, 0, 1, 1, true, (ii%cube_data_tsv)+(jj*cube_data_tsv), true ) );
-						//cout << "|" <<(ii%cube_data_tsv)+(jj*cube_data_tsv)<< "|";
-					} 
+					insertTSVRanges( ii%cube_data_tsv, true );
 					tsv_info[ii]=4;
 				}
 			}
 		}
 	}
 
-	curr_interval++;
-	
-	return (newfault0 || newfault1);
+	return newfault1;
+}
+
+// A failed data TSV corrupts every cube_data_tsv'th bit of each row, starting at bit tsv. When
+// cube_data_tsv is a power of two those bits are exactly the ones whose low log2(cube_data_tsv)
+// column/bit address bits equal tsv, so a single range with the upper column/bit bits wild covers
+// them all. Otherwise fall back to one range per bit position.
+
+void DRAMDomain::insertTSVRanges( uint64_t tsv, bool transient )
+{
+	uint64_t n_rowbits = (uint64_t)m_cols * m_bitwidth;
+
+	if( (cube_data_tsv & (cube_data_tsv-1)) == 0 && cube_data_tsv <= n_rowbits ) {
+		FaultRange *fr = genRandomRange( 0, 0, 0, 1, 1, transient, tsv, true );
+		fr->fWildMask |= (n_rowbits-1) & ~(cube_data_tsv-1);
+		fr->max_faults *= n_rowbits / cube_data_tsv;
+		insertRange( fr );
+	} else {
+		for( uint64_t jj = 0; jj < n_rowbits/cube_data_tsv; jj++ ) {
+			insertRange( genRandomRange( 0, 0, 0, 1, 1, transient, tsv+(jj*cube_data_tsv), true ) );
+		}
+	}
 }
 
 #define min(a,b) (a<b) ? a : b
@@ -216,15 +434,11 @@ void DRAMDomain::reset( void )
 {
 	FaultDomain::reset();
 
-	// delete all faults
-	list<FaultRange*>::iterator it;
-
-	for( it = m_faultRanges.begin(); it != m_faultRanges.end(); it++ )
-	{
-		delete (*it);
-	}
-
+	// forget all faults, the memory of generated FaultRanges is released by Simulation::reset
 	m_faultRanges.clear();
+	m_onDieRanges.clear();
+	n_transient_ranges = 0;
+	next_fault_valid = false;
 
 	// DR DEBUG - insert known faults
 	/*
@@ -255,30 +469,23 @@ void DRAMDomain::dumpState( void )
 	{
 		cout << m_name << " ";
 
-		list<FaultRange*>::iterator it;
-
-		for( it = m_faultRanges.begin(); it != m_faultRanges.end(); it++ )
+		for( uint32_t i = 0; i < m_faultRanges.size(); i++ )
 		{
-			cout << (*it)->toString() << "\n";
+			cout << m_faultRanges.toString( i ) << "\n";
 		}
+		if( m_faultRanges.getFoldedCount() != 0 ) cout << m_name << " folded " << m_faultRanges.getFoldedCount() << "\n";
 	}
+
+	if( m_onDieRanges.size() != 0 ) cout << m_name << " on-die corrected " << m_onDieRanges.size() << "\n";
 }
 
 void DRAMDomain::scrub( void )
 {
 	FaultDomain::scrub();
 
-	// delete all transient faults
-	list<FaultRange*>::iterator it;
-	for( it = m_faultRanges.begin(); it != m_faultRanges.end(); it++ )
-	{
-		if( (*it)->transient ) {
-			if((*it)->transient_remove)
-			{
-				it = m_faultRanges.erase( it );
-			}
-		}
-	}
+	// remove all transient faults
+	n_transient_ranges -= m_faultRanges.scrub();
+	n_transient_ranges -= m_onDieRanges.scrub();
 }
 
 void DRAMDomain::setFIT( int faultClass, bool isTransient, double FIT )
@@ -290,6 +497,15 @@ void DRAMDomain::setFIT( int faultClass, bool isTransient, double FIT )
 	}
 }
 
+void DRAMDomain::setFITProfile( int faultClass, bool isTransient, FITProfile *profile )
+{
+	if( isTransient ) {
+		fit_profile[faultClass] = profile;
+	} else {
+		fit_profile[faultClass+DRAM_MAX] = profile;
+	}
+}
+
 void DRAMDomain::init( uint64_t interval, uint64_t sim_seconds, double fit_factor )
 {
 	FaultDomain::init( interval, sim_seconds, fit_factor );
@@ -303,6 +519,11 @@ void DRAMDomain::init( uint64_t interval, uint64_t sim_seconds, double fit_facto
 	for( int i = DRAM_MAX; i < DRAM_MAX*2; i++ ) {
 		hrs_per_fault[i] = ((double)1000000000.0) / (permanentFIT[i-DRAM_MAX] * fit_factor);
 	}
+	double rate = 0;
+	for( int i = 0; i < DRAM_MAX*2; i++ ) {
+		if( fit_profile[i] == NULL ) rate += 1 / hrs_per_fault[i];
+		m_constantRate[i] = rate;
+	}
 	////////////////////////////////////////////////////////////////////
 
 	// 1 FIT = 10^9 device-hours
@@ -331,31 +552,31 @@ void DRAMDomain::generateRanges( int faultClass, bool transient )
 {
 	switch( faultClass ) {
 	case DRAM_1BIT:
-		m_faultRanges.push_back( genRandomRange( 1, 1, 1, 1, 1,transient, -1, false) );
+		insertRange( genRandomRange( 1, 1, 1, 1, 1,transient, -1, false) );
 		break;
 
 	case DRAM_1WORD:
-		m_faultRanges.push_back( genRandomRange( 1, 1, 1, 1, 0,transient, -1, false) );
+		insertRange( genRandomRange( 1, 1, 1, 1, 0,transient, -1, false) );
 		break;
 
 	case DRAM_1COL:
-		m_faultRanges.push_back( genRandomRange( 1, 1, 0, 1, 0,transient, -1, false) );
+		insertRange( genRandomRange( 1, 1, 0, 1, 0,transient, -1, false) );
 		break;
 
 	case DRAM_1ROW:
-		m_faultRanges.push_back( genRandomRange( 1, 1, 1, 0, 0,transient, -1, false) );
+		insertRange( genRandomRange( 1, 1, 1, 0, 0,transient, -1, false) );
 		break;
 
 	case DRAM_1BANK:
-		m_faultRanges.push_back( genRandomRange( 1, 1, 0, 0, 0,transient, -1, false) );
+		insertRange( genRandomRange( 1, 1, 0, 0, 0,transient, -1, false) );
 		break;
 
 	case DRAM_NBANK:
-		m_faultRanges.push_back( genRandomRange( 1, 0, 0, 0, 0,transient, -1, false) );
+		insertRange( genRandomRange( 1, 0, 0, 0, 0,transient, -1, false) );
 		break;
 
 	case DRAM_NRANK:
-		m_faultRanges.push_back( genRandomRange( 0, 0, 0, 0, 0,transient, -1, false) );
+		insertRange( genRandomRange( 0, 0, 0, 0, 0,transient, -1, false) );
 		break;
 
 	default:
@@ -510,14 +731,18 @@ void DRAMDomain::printStats( void )
 
 	cout << "TSV " << n_faults_permanent_tsv;
 
+	if( m_onDieBits != 0 ) {
+		cout << " OnDie: corrected " << n_ondie_corrected << " promoted " << n_ondie_promoted
+		     << " miscorrected " << n_ondie_miscorrected;
+	}
+
 	cout << "\n";
 
 	// For extra verbose mode, output list of all fault ranges
 	if( settings.verbose == 2 ) {
-		list<FaultRange*>::iterator it;
-		for( it = m_faultRanges.begin(); it != m_faultRanges.end(); it++ )
+		for( uint32_t i = 0; i < m_faultRanges.size(); i++ )
 		{
-			cout << "FR " << (*it)->toString() << "\n";
+			cout << "FR " << m_faultRanges.toString( i ) << "\n";
 		}
 	}
 }
@@ -18,7 +18,9 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include <list>
 
 #include "FaultDomain.hh"
+#include "FaultStore.hh"
 class FaultRange;
+class FITProfile;
 
 // 32-bit random integers for determining fault locations
 typedef boost::mt19937						ENG32;
@@ -29,13 +31,24 @@ class DRAMDomain : public FaultDomain
 	DRAMDomain( char *name, uint32_t n_bitwidth, uint32_t n_ranks, uint32_t n_banks, uint32_t n_rows, uint32_t n_cols);
 
 	void setFIT( int faultClass, bool isTransient, double FIT );
+	void setFITProfile( int faultClass, bool isTransient, FITProfile *profile );	// make a FIT rate vary with device age
     void init( uint64_t interval, uint64_t sim_seconds, double fit_factor );
 	int update(uint test_mode_t);	// perform one iteration
+	uint64_t getNextFaultInterval( void );
+	int updateTSV( void );	// insert ranges for failed TSVs of this chip
+	void insertTSVRanges( uint64_t tsv, bool transient );	// ranges for all bits carried by one data TSV
 	void repair( uint64_t &n_undetectable, uint64_t &n_uncorrectable );
 	void scrub( void );
 	virtual void reset( void );
+	void addCodewordBits( uint32_t bits );
+	// correct single-bit errors in each codeword of this many data bits (a power of two) inside the chip
+	void setOnDieECC( uint32_t data_bits );
     
-	list<FaultRange*> *getRanges( void );
+	FaultStore *getRanges( void );
+	FaultStore *getOnDieRanges( void );
+	void insertRange( FaultRange *fr );	// add (a copy of) a fault range to this chip
+	void retireRanges( const vector<uint32_t> &indices );	// remove permanent faults repaired by sparing
+	uint64_t getTransientRangeCount( void );
 
 	void dumpState( void );
 	void printStats( void );
@@ -64,21 +77,45 @@ class DRAMDomain : public FaultDomain
 
 	// Parameters for event-driven simulation (hours per fault transient followed by permanent
 	double hrs_per_fault[DRAM_MAX*2];
+	FITProfile *fit_profile[DRAM_MAX*2];	// NULL for a constant FIT rate
+	double nextFaultTime( int faultType, double time_s, double max_s );	// arrival time (seconds) of the next fault after time_s
+	// the fault types with a constant FIT rate as one arrival process: the next arrival after
+	// time_s, and the type of an arrival
+	double nextConstantFaultTime( double time_s );
+	int drawConstantFaultType( void );
 
-	list<FaultRange*> m_faultRanges;
+	// For interval-based simulation: next interval with a fault in each class (transient followed by permanent)
+	uint64_t next_fault_interval[DRAM_MAX*2];
+	bool next_fault_valid;	// next_fault_interval has been drawn for this simulation
+
+	FaultStore m_faultRanges;	// faults seen by the module-level repair schemes
+	FaultStore m_onDieRanges;	// faults the on-die code corrects, alone in each of their codewords
 
 	ENG  eng;
 	DIST dist;
 	GEN  gen;
 	ENG32 eng32;
 
-	uint64_t curr_interval;
 
 	protected:
 	uint64_t n_faults_transient_class[DRAM_MAX];
 	uint64_t n_faults_permanent_class[DRAM_MAX];
 
 	uint64_t n_faults_transient_tsv, n_faults_permanent_tsv;
+	uint64_t n_transient_ranges;	// transient ranges currently in m_faultRanges
+
+	void drawNextFaults( void );
+	void insertOnDie( FaultRange *fr );
+
+	// on-die SEC: codeword address bits (0 without on-die ECC) and the probability that it turns a
+	// double-bit error into a triple-bit one
+	uint32_t m_onDieBits;
+	double m_onDieMiscorrect;
+	uint64_t n_ondie_corrected, n_ondie_promoted, n_ondie_miscorrected;
+	vector<uint32_t> m_onDieHits;
+
+	// faults per hour of the fault types with a constant FIT rate, summed over the types up to each one
+	double m_constantRate[DRAM_MAX*2];
 
 	uint32_t m_bitwidth, m_ranks, m_banks, m_rows, m_cols;
 	uint32_t m_logBits, m_logRanks, m_logBanks, m_logRows, m_logCols;
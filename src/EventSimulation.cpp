@@ -15,10 +15,14 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "FaultDomain.hh"
 #include "DRAMDomain.hh"
 #include "FaultRange.hh"
+#include "GroupDomain_cube.hh"
 #include <list>
 #include <iostream>
 #include <fstream>
 #include <queue>
+#include <vector>
+#include <algorithm>
+#include <set>
 #include <iomanip>
 #include <stdio.h>
 #include <math.h>
@@ -26,212 +30,281 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include <inttypes.h>
 using namespace std;
 
-class CompareFR {
-public:
-	bool operator()(FaultRange*& f1, FaultRange*& f2)
-	{
-		if( f1->timestamp < f2->timestamp ) return true;
-		return false;
-	}
-};
-
-
 EventSimulation::EventSimulation( uint64_t interval_t, uint64_t scrub_interval_t, double fit_factor_t , uint test_mode_t,
 									bool debug_mode_t, bool cont_running_t, uint64_t output_bucket_t)
 : Simulation( interval_t, scrub_interval_t, fit_factor_t, test_mode_t, debug_mode_t, cont_running_t, output_bucket_t)
 {
 }
 
-// Event-driven simulation takes over the task of injecting errors into the chips
-// from the DRAMDomains. It also advances time in variable increments according to event times
+// Queue a fault of one type arriving in a chip at the given time
 
-uint64_t EventSimulation::runOne( uint64_t max_s, int verbose, uint64_t bin_length)
+void EventSimulation::addFaultEvent( FaultDomain *module, DRAMDomain *pD, int errtype, double timestamp, EventQueue &q )
 {
-	// returns number of uncorrectable simulations
-	priority_queue<FaultRange*, vector<FaultRange*>, CompareFR> q1;
+	FaultRange *fr = NULL;
+	if(errtype==0)
+	{
+		fr = pD->genRandomRange( 1, 1, 1, 1, 1, 1, -1, 0);
+	}
+	else if(errtype==1)
+	{
+		fr = pD->genRandomRange( 1, 1, 1, 1, 0, 1, -1, 0);
+	}
+	else if(errtype==2)
+	{
+		fr = pD->genRandomRange( 1, 1, 0, 1, 0, 1, -1, 0);
+	}
+	else if(errtype==3)
+	{
+		fr = pD->genRandomRange( 1, 1, 1, 0, 0, 1, -1, 0);
+	}
+	else if(errtype==4)
+	{
+		fr = pD->genRandomRange( 1, 1, 0, 0, 0, 1, -1, 0);
+	}
+	else if(errtype==5)
+	{
+		fr = pD->genRandomRange( 1, 0, 0, 0, 0, 1, -1, 0);
+	}
+	else if(errtype==6)
+	{
+		fr = pD->genRandomRange( 0, 0, 0, 0, 0, 1, -1, 0);
+	}
+	else if(errtype==7)
+	{
+		fr = pD->genRandomRange( 1, 1, 1, 1, 1, 0, -1, 0);
+	}
+	else if(errtype==8)
+	{
+		fr = pD->genRandomRange( 1, 1, 1, 1, 0, 0, -1, 0);
+	}
+	else if(errtype==9)
+	{
+		fr = pD->genRandomRange( 1, 1, 0, 1, 0, 0, -1, 0);
+	}
+	else if(errtype==10)
+	{
+		fr = pD->genRandomRange( 1, 1, 1, 0, 0, 0, -1, 0);
+	}
+	else if(errtype==11)
+	{
+		fr = pD->genRandomRange( 1, 1, 0, 0, 0, 0, -1, 0);
+	}
+	else if(errtype==12)
+	{
+		fr = pD->genRandomRange( 1, 0, 0, 0, 0, 0, -1, 0);
+	}
+	else if(errtype==13)
+	{
+		fr = pD->genRandomRange( 0, 0, 0, 0, 0, 0, -1, 0);
+	}
 
-	// reset the domain states e.g. recorded errors for the simulated timeframe
-	reset();
-	uint64_t bin;
+	fr->timestamp = timestamp;
+	if( fr->transient ) fr->m_pDRAM->n_faults_transient++;
+	else fr->m_pDRAM->n_faults_permanent++;
 
-	// New for Event-Driven: set up the time-ordered event list
-	// Get access to a DRAM domain
-	list<FaultDomain*> *pChips = m_domains.front()->getChildren();
+	FaultEvent ev;
+	ev.type = EV_DRAM;
+	ev.timestamp = timestamp;
+	ev.pModule = module;
+	ev.fr = fr;
+	ev.pCube = NULL;
+	ev.transient = fr->transient;
+	q.push( ev );
+}
 
-	int err_inserted = 0;
+// Draw the arrival times of all faults of one top-level domain over the simulated timeframe
+
+void EventSimulation::genEvents( FaultDomain *module, uint64_t max_s, EventQueue &q )
+{
+	// Get access to the DRAM domains of this module
+	list<FaultDomain*> *pChips = module->getChildren();
 
-	int devices = 0;
 	for( list<FaultDomain*>::iterator it1 = pChips->begin(); it1 != pChips->end(); it1++ )
 	{
 		DRAMDomain* pD = (DRAMDomain*)(*it1);
-		double period=0;
+
+		// the fault types with a constant FIT rate arrive together, each arrival of a random type
+		for( double t = pD->nextConstantFaultTime( 0 ); t <= max_s; t = pD->nextConstantFaultTime( t ) ) {
+			addFaultEvent( module, pD, pD->drawConstantFaultType(), t, q );
+		}
+
+		// the ones with an age-dependent rate one by one
 		for(int errtype=0; errtype<DRAM_MAX*2; errtype++)
+		{
+			if( pD->fit_profile[errtype] == NULL ) continue;
+
+			double currtime=0;
+			while(currtime <= ((double)max_s)){
+				currtime = pD->nextFaultTime( errtype, currtime, max_s );
+				if(currtime <= max_s){
+					addFaultEvent( module, pD, errtype, currtime, q );
+				}
+			}
+		}
+	}
+
+	// TSV faults are common to the whole stack, so they are drawn from the module's FIT rates
+	GroupDomain_cube *pCube = dynamic_cast<GroupDomain_cube*>(module);
+	if( (pCube != NULL) && pCube->enable_tsv )
+	{
+		for(int tsvtype=0; tsvtype<2; tsvtype++)
 		{
 			double currtime=0;
 			while(currtime <= ((double)max_s)){
-				period = -1*log(pD->gen())*pD->hrs_per_fault[errtype] * (60 * 60); //Exponential interval in SECONDS
+				double period = -1*log(pCube->gen())*pCube->hrs_per_fault_tsv[tsvtype] * (60 * 60); //Exponential interval in SECONDS
 				currtime += period;
 				if(currtime <= max_s){
-					double timestamp = currtime;
-					FaultRange *fr = NULL;
-					if(errtype==0)
-					{
-						fr = pD->genRandomRange( 1, 1, 1, 1, 1, 1, -1, 0);
-					}
-					else if(errtype==1)
-					{
-						fr = pD->genRandomRange( 1, 1, 1, 1, 0, 1, -1, 0);
-					}
-					else if(errtype==2)
-					{
-						fr = pD->genRandomRange( 1, 1, 0, 1, 0, 1, -1, 0);
-					}
-					else if(errtype==3)
-					{
-						fr = pD->genRandomRange( 1, 1, 1, 0, 0, 1, -1, 0);
-					}
-					else if(errtype==4)
-					{
-						fr = pD->genRandomRange( 1, 1, 0, 0, 0, 1, -1, 0);
-					}
-					else if(errtype==5)
-					{
-						fr = pD->genRandomRange( 1, 0, 0, 0, 0, 1, -1, 0);
-					}
-					else if(errtype==6)
-					{
-						fr = pD->genRandomRange( 0, 0, 0, 0, 0, 1, -1, 0);
-					}
-					else if(errtype==7)
-					{
-						fr = pD->genRandomRange( 1, 1, 1, 1, 1, 0, -1, 0);
-					}
-					else if(errtype==8)
-					{
-						fr = pD->genRandomRange( 1, 1, 1, 1, 0, 0, -1, 0);
-					}
-					else if(errtype==9)
-					{
-						fr = pD->genRandomRange( 1, 1, 0, 1, 0, 0, -1, 0);
-					}
-					else if(errtype==10)
-					{
-						fr = pD->genRandomRange( 1, 1, 1, 0, 0, 0, -1, 0);
-					}
-					else if(errtype==11)
-					{
-						fr = pD->genRandomRange( 1, 1, 0, 0, 0, 0, -1, 0);
-					}
-					else if(errtype==12)
-					{
-						fr = pD->genRandomRange( 1, 0, 0, 0, 0, 0, -1, 0);
-					}
-					else if(errtype==13)
-					{
-						fr = pD->genRandomRange( 0, 0, 0, 0, 0, 0, -1, 0);
-					}
-
-					fr->timestamp = timestamp;
-					if( fr->transient ) fr->m_pDRAM->n_faults_transient++;
-					else fr->m_pDRAM->n_faults_permanent++;
-					q1.push( fr );
-					//iter_num_errors++;
-					err_inserted=1;
+					FaultEvent ev;
+					ev.type = EV_TSV;
+					ev.timestamp = currtime;
+					ev.pModule = module;
+					ev.fr = NULL;
+					ev.pCube = pCube;
+					ev.transient = (tsvtype == 0);
+					q.push( ev );
 				}
 			}
 		}
+	}
+}
+
+// Insert the faults of an event into the chips of its module.
+// Returns false if the event did not add any new fault.
 
-		devices++;
+bool EventSimulation::insertEvent( const FaultEvent &ev )
+{
+	if( ev.type == EV_DRAM ) {
+		DRAMDomain *pDRAM = ev.fr->m_pDRAM;
+		pDRAM->insertRange( ev.fr );
+		return true;
+	}
+
+	// Fail a TSV and let the chip that owns it insert the resulting FaultRanges,
+	// exactly as DRAMDomain::update does in the interval-based simulator
+	if( ev.pCube->genTSVFault( ev.transient ) < 0 ) return false;	// TSV had already failed
+
+	list<FaultDomain*> *pStackChips = ev.pCube->getChildren();
+	for( list<FaultDomain*>::iterator it1 = pStackChips->begin(); it1 != pStackChips->end(); it1++ )
+	{
+		((DRAMDomain*)(*it1))->updateTSV();
+	}
+
+	return true;
+}
+
+// Event-driven simulation takes over the task of injecting errors into the chips
+// from the DRAMDomains. It also advances time in variable increments according to event times.
+// The events of all registered top-level domains are merged into one time-ordered list,
+// and only the modules that received a fault are repaired at each step. Scrubs are
+// events too, scheduled only for modules holding transient faults that may be removed.
+
+uint64_t EventSimulation::runOne( uint64_t max_s, int verbose, uint64_t bin_length)
+{
+	// returns number of uncorrectable simulations
+	EventQueue q1;
+
+	// reset the domain states e.g. recorded errors for the simulated timeframe
+	reset();
+	uint64_t bin;
+
+	// New for Event-Driven: set up the time-ordered event list
+	list<FaultDomain*>::iterator it;
+	for( it = m_domains.begin(); it != m_domains.end(); it++ ) {
+		genEvents( (*it), max_s, q1 );
 	}
 
 	// Step through the event list, injecting a fault into corresponding chip at each event, and invoking ECC
-	uint64_t n_undetected = 0;
-	uint64_t n_uncorrected = 0;
 	uint64_t errors=0;
-	uint64_t old_scrubid = 0;
-	uint64_t new_scrubid = 0;
+	vector<FaultDomain*> dirty;	// modules that received faults since they were last repaired
+	set<FaultDomain*> scrub_pending;	// modules with a scrub event in the queue
 
 	//Run the Repair function: This will check the correctability/ detectability of the fault(s); Repairing is also done instantaneously
 	while( !q1.empty() ) {
-      //  printf("calling repair\n");
-		FaultRange *fr = q1.top();
-		DRAMDomain *pDRAM = fr->m_pDRAM;
-		pDRAM->m_faultRanges.push_back( fr );
-
-		if( verbose == 2 ) {
-			// Dump all FaultRanges before
-			cout << "FAULTS INSERTED: BEFORE REPAIR\n";
-			// DR DEBUG check all domains, not just the first one
-			m_domains.front()->dumpState();
-		}
+		// Insert all faults occurring at this instant before invoking ECC, so that each
+		// affected module is evaluated once
+		double timestamp = q1.top().timestamp;
+		dirty.clear();
+		while( !q1.empty() && (q1.top().timestamp == timestamp) ) {
+			FaultEvent ev = q1.top();
+			q1.pop();
 
-        	errors=0;
-		m_domains.front()->repair( n_undetected, n_uncorrected );//Calls repair  function
-		if( verbose == 2 ) {
-			// Dump all FaultRanges after
-			cout << "FAULTS INSERTED: AFTER REPAIR\n";
-			m_domains.front()->dumpState();
+			if( ev.type == EV_SCRUB ) {
+				scrub_pending.erase( ev.pModule );
+				ev.pModule->scrub();
+
+				//User Defined Special operation to be performed while Scrubbing
+				if( ev.pModule->fill_repl() ) {
+					finalize();
+					return 1;
+				}
+			} else if( insertEvent( ev ) && (find( dirty.begin(), dirty.end(), ev.pModule ) == dirty.end()) ) {
+				dirty.push_back( ev.pModule );
+			}
 		}
-		q1.pop();
-         
-       		// printf("ECC Undetected %d Uncorrected %d \n", n_undetected, n_uncorrected); 
-
-		if (!cont_running)
-		    {
-				if( n_undetected || n_uncorrected ) {
-				// if any iteration fails to repair, halt the simulation and report failure
-				finalize();
+
+		for( vector<FaultDomain*>::iterator itd = dirty.begin(); itd != dirty.end(); itd++ ) {
+			FaultDomain *module = (*itd);
+			uint64_t n_undetected = 0;
+			uint64_t n_uncorrected = 0;
+
+			if( verbose == 2 ) {
+				// Dump all FaultRanges before
+				cout << "FAULTS INSERTED: BEFORE REPAIR\n";
+				module->dumpState();
+			}
+
+			module->repair( n_undetected, n_uncorrected );//Calls repair  function
+
+			if( verbose == 2 ) {
+				// Dump all FaultRanges after
+				cout << "FAULTS INSERTED: AFTER REPAIR\n";
+				module->dumpState();
+			}
+
+			if( n_undetected || n_uncorrected ) {
 				//Update the appropriate Bin to log into the output file
-				bin = fr->timestamp/bin_length;
-				fail_time_bins[bin]++;
-		    
-			if(n_uncorrected>0)
-			fail_uncorrectable[bin]++;
-			if(n_undetected>0)
-			fail_undetectable[bin]++;
-
-				return 1;
-				 }
-		    }
-		else 
-		{
-		    if(n_undetected ||n_uncorrected)
-			{
-			errors++;
-			bin = fr->timestamp/bin_length;
+				bin = timestamp/bin_length;
 				fail_time_bins[bin]++;
-			if(n_uncorrected>0)
-			fail_uncorrectable[bin]++;
-			if(n_undetected>0)
-			fail_undetectable[bin]++;
+
+				if(n_uncorrected>0)
+					fail_uncorrectable[bin]++;
+				if(n_undetected>0)
+					fail_undetectable[bin]++;
+
+				if (!cont_running) {
+					// if any iteration fails to repair, halt the simulation and report failure
+					finalize();
+					return 1;
+				}
+
+				errors++;
 			}
-		}
 
-		//Scrubbing is performed after the fault has occured and the system isnt failed
-		//Timeline analysis of the scrubbing operation
-		//-------------*-----|--------*-------*---------------|---------------------/
-		//* indicates faults and | indicates the scrub interval
-		//If the scrub id (interval id) for scrub between any subsequent faults is the same, we cannot invoke scrubbing again (middle
-		// region in the timeline)
-		
-		new_scrubid = fr->timestamp/m_scrub_interval;	
-                if(new_scrubid!=old_scrubid) {
-                        for(list<FaultDomain*>::iterator it = m_domains.begin(); it != m_domains.end(); it++ ) {
-                                (*it)->scrub();
-                                if((*it)->fill_repl()){
-                                        finalize();
-                                        return 1;
-                                }
+			//Scrubbing removes correctable transient faults at the end of the scrub interval
+			//in which they occurred. Modules without such faults are never scrubbed.
+			//-------------*-----|--------*-------*---------------|---------------------/
+			//* indicates faults and | indicates the scrub interval
+			if( module->needsScrub() && (scrub_pending.count( module ) == 0) ) {
+				double scrub_time = (floor( timestamp/m_scrub_interval ) + 1) * m_scrub_interval;
+				if( scrub_time <= max_s ) {
+					FaultEvent ev;
+					ev.type = EV_SCRUB;
+					ev.timestamp = scrub_time;
+					ev.pModule = module;
+					ev.fr = NULL;
+					ev.pCube = NULL;
+					ev.transient = false;
+					q1.push( ev );
+					scrub_pending.insert( module );
+				}
 			}
 		}
-		old_scrubid = new_scrubid;
 	} //End of the loop for all faults
 	/***********************************************/
-	//   printf("ECC Undetected %d Uncorrected %d \n", n_undetected, n_uncorrected); 
 
 	finalize();
-    	if(errors>0)
-    	return 1;
-    	else
-	return 0;
+	if(errors>0)
+		return 1;
+	else
+		return 0;
 }
@@ -14,6 +14,43 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #define EVENTSIMULATION_HH_
 
 #include "Simulation.hh"
+#include <queue>
+#include <vector>
+
+class FaultRange;
+class DRAMDomain;
+class GroupDomain_cube;
+
+// Event types
+#define EV_DRAM  0	// DRAM fault
+#define EV_TSV   1	// TSV fault of a 3D stack
+#define EV_SCRUB 2	// scrub of a module holding transient faults
+
+// An entry in the time-ordered event list. DRAM faults are drawn up front together with
+// their FaultRange; TSV faults only record the arrival and are expanded into FaultRanges
+// by the owning chip when the event is processed.
+class FaultEvent {
+public:
+	int type;			// EV_DRAM, EV_TSV or EV_SCRUB
+	double timestamp;		// time in seconds at which the fault occurs
+	FaultDomain *pModule;		// top-level domain receiving the event
+	FaultRange *fr;			// DRAM fault (EV_DRAM only)
+	GroupDomain_cube *pCube;	// stack whose TSV fails (EV_TSV only)
+	bool transient;
+};
+
+class CompareEvent {
+public:
+	bool operator()(const FaultEvent &e1, const FaultEvent &e2)
+	{
+		// priority_queue pops its largest element first, so the latest event must
+		// compare as the smallest to step through the events in time order
+		if( e1.timestamp > e2.timestamp ) return true;
+		return false;
+	}
+};
+
+typedef priority_queue<FaultEvent, vector<FaultEvent>, CompareEvent> EventQueue;
 
 class EventSimulation : public Simulation {
 public:
@@ -21,6 +58,11 @@ public:
 				     bool cont_running_t, uint64_t output_bucket_t );	
 	// Simulation loop for a single simulation in Event Driven mode
 	virtual uint64_t runOne( uint64_t max_time, int verbose, uint64_t bin_length );
+
+protected:
+	void genEvents( FaultDomain *module, uint64_t max_s, EventQueue &q );
+	void addFaultEvent( FaultDomain *module, DRAMDomain *pD, int errtype, double timestamp, EventQueue &q );
+	bool insertEvent( const FaultEvent &ev );
 };
 
 
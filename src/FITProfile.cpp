@@ -0,0 +1,142 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "FITProfile.hh"
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <math.h>
+
+static void profileError( const string &spec, const char *msg )
+{
+	cout << "ERROR: Invalid FIT profile '" << spec << "': " << msg << "\n";
+	exit(0);
+}
+
+FITProfile::FITProfile( const string &spec )
+{
+	istringstream in( spec );
+	string word;
+
+	while( in >> word ) {
+		FITProfileTerm term;
+
+		if( word == "constant" ) {
+			term.type = PROFILE_CONSTANT;
+			if( !(in >> term.value) || term.value < 0 ) profileError( spec, "constant needs a non-negative multiplier" );
+			in >> word;
+		} else if( word == "weibull" ) {
+			term.type = PROFILE_WEIBULL;
+			term.min_age = 1;
+			if( !(in >> term.shape >> term.scale) || term.shape <= 0 || term.scale <= 0 ) {
+				profileError( spec, "weibull needs a positive shape and scale" );
+			}
+			// optional minimum age
+			if( in >> word && word != "+" ) {
+				term.min_age = atof( word.c_str() );
+				if( term.min_age <= 0 ) profileError( spec, "weibull minimum age must be positive" );
+				in >> word;
+			}
+		} else if( word == "piecewise" ) {
+			term.type = PROFILE_PIECEWISE;
+			while( in >> word && word != "+" ) {
+				double age, value;
+				char sep;
+				istringstream point( word );
+				if( !(point >> age >> sep >> value) || sep != ':' || value < 0 ) {
+					profileError( spec, "piecewise points must be <age_hours>:<multiplier>" );
+				}
+				if( !term.ages.empty() && age <= term.ages.back() ) profileError( spec, "piecewise ages must increase" );
+				term.ages.push_back( age );
+				term.values.push_back( value );
+			}
+			if( term.ages.empty() ) profileError( spec, "piecewise needs at least one point" );
+		} else {
+			profileError( spec, "terms must be constant, piecewise or weibull" );
+		}
+
+		m_terms.push_back( term );
+
+		// every term is followed by '+' or the end of the profile
+		if( !in.eof() && word != "+" ) profileError( spec, "terms must be separated by '+'" );
+	}
+
+	if( m_terms.empty() ) profileError( spec, "empty profile" );
+}
+
+double FITProfile::multiplier( double hours )
+{
+	double m = 0;
+
+	for( vector<FITProfileTerm>::iterator it = m_terms.begin(); it != m_terms.end(); it++ ) {
+		m += it->multiplier( hours );
+	}
+
+	return m;
+}
+
+double FITProfile::bound( double from_hours, double to_hours )
+{
+	double m = 0;
+
+	for( vector<FITProfileTerm>::iterator it = m_terms.begin(); it != m_terms.end(); it++ ) {
+		m += it->bound( from_hours, to_hours );
+	}
+
+	return m;
+}
+
+double FITProfile::average( double to_hours )
+{
+	// midpoint rule, only used for estimates
+	uint32_t steps = 1000;
+	double sum = 0;
+
+	for( uint32_t i = 0; i < steps; i++ ) {
+		sum += multiplier( ( i + 0.5 ) * to_hours / steps );
+	}
+
+	return sum / steps;
+}
+
+double FITProfileTerm::multiplier( double hours )
+{
+	if( type == PROFILE_CONSTANT ) {
+		return value;
+	} else if( type == PROFILE_WEIBULL ) {
+		if( hours < min_age ) hours = min_age;
+		return shape * pow( hours / scale, shape - 1 );
+	} else {
+		// the first value also applies before the first age
+		uint32_t i = 0;
+		while( i + 1 < ages.size() && ages[i+1] <= hours ) i++;
+		return values[i];
+	}
+}
+
+double FITProfileTerm::bound( double from_hours, double to_hours )
+{
+	if( type == PROFILE_CONSTANT ) {
+		return value;
+	} else if( type == PROFILE_WEIBULL ) {
+		// the Weibull hazard is monotonic, so its maximum is at either end
+		double m0 = multiplier( from_hours );
+		double m1 = multiplier( to_hours );
+		return ( m0 > m1 ) ? m0 : m1;
+	} else {
+		double m = multiplier( from_hours );
+		for( uint32_t i = 0; i < ages.size(); i++ ) {
+			if( ages[i] > from_hours && ages[i] <= to_hours && values[i] > m ) m = values[i];
+		}
+		return m;
+	}
+}
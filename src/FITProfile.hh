@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef FITPROFILE_HH_
+#define FITPROFILE_HH_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define PROFILE_CONSTANT 0
+#define PROFILE_PIECEWISE 1
+#define PROFILE_WEIBULL 2
+
+// One term of a FIT profile, see FITProfile
+class FITProfileTerm
+{
+	public:
+	int type;
+	double value;				// PROFILE_CONSTANT: multiplier
+	double shape, scale, min_age;	// PROFILE_WEIBULL: shape, scale and minimum age (hours)
+	vector<double> ages, values;	// PROFILE_PIECEWISE: multiplier values[i] from ages[i] (hours) on
+
+	double multiplier( double hours );
+	double bound( double from_hours, double to_hours );
+};
+
+// Describes how the FIT rate of a fault class changes with the age of the device, as a
+// multiplier of the FIT rate set for the class. A profile is a sum of terms separated by '+':
+//   constant <m>                        : multiplier m at all ages
+//   piecewise <h0>:<m0> <h1>:<m1> ...   : multiplier mi from age hi hours until the next age
+//   weibull <shape> <scale> [<min_age>] : multiplier shape*(age/scale)^(shape-1) i.e. the hazard
+//                                         of a Weibull distribution normalized to the FIT rate.
+//                                         Evaluated no earlier than min_age hours (default 1) so
+//                                         that infant mortality (shape < 1) stays bounded.
+// e.g. a bathtub curve: "weibull 0.5 8760 + constant 0.5 + weibull 4 87600"
+
+class FITProfile
+{
+	public:
+	FITProfile( const string &spec );
+
+	double multiplier( double hours );	// FIT multiplier at an age
+	double bound( double from_hours, double to_hours );	// upper bound of the multiplier over a range of ages
+	double average( double to_hours );	// mean multiplier from age 0 until an age
+
+	protected:
+	vector<FITProfileTerm> m_terms;
+};
+
+
+#endif /* FITPROFILE_HH_ */
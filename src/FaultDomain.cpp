@@ -27,11 +27,14 @@ FaultDomain::FaultDomain( const char *name_t)
 	n_faults_transient = n_faults_permanent = 0;
 	// Errors after detection/correction
 	n_errors_undetected = n_errors_uncorrected = 0;
+	n_transient_ranges_scrubbed = 0;
+	n_faults_permanent_filled = 0;
 	tsv_transientFIT = 0;
         tsv_permanentFIT = 0;
 	cube_model_enable=0;
 	cube_addr_dec_depth=0;
 	children_counter=0;
+	curr_interval=0;
 }
 
 string FaultDomain::getName( void )
@@ -54,6 +57,9 @@ void FaultDomain::reset( void )
 	// reset per-simulation statistics used internally
 	n_faults_transient = n_faults_permanent = 0;
 	n_errors_undetected = n_errors_uncorrected = 0;	// used to indicate whether the domain failed during a single simulation
+	n_transient_ranges_scrubbed = 0;
+	n_faults_permanent_filled = 0;
+	curr_interval = 0;
 	stat_n_simulations++;
 
 	list<FaultDomain*>::iterator it;
@@ -159,9 +165,43 @@ int FaultDomain::update(uint test_mode_t)
 	return return_val;
 }
 
+uint64_t FaultDomain::getNextFaultInterval( void )
+{
+	uint64_t next = NO_FAULT_INTERVAL;
+	list<FaultDomain*>::iterator it;
+
+	for( it = m_children.begin(); it != m_children.end(); it++ ) {
+		uint64_t child_next = (*it)->getNextFaultInterval();
+		if( child_next < next ) next = child_next;
+	}
+
+	return next;
+}
+
+void FaultDomain::setInterval( uint64_t interval )
+{
+	curr_interval = interval;
+
+	list<FaultDomain*>::iterator it;
+
+	for( it = m_children.begin(); it != m_children.end(); it++ ) {
+		(*it)->setInterval( interval );
+	}
+}
+
 void FaultDomain::addRepair( RepairScheme *repair )
 {
 	m_repairSchemes.push_back( repair );
+	addCodewordBits( repair->getCodewordBits() );
+}
+
+void FaultDomain::addCodewordBits( uint32_t bits )
+{
+	list<FaultDomain*>::iterator it;
+
+	for( it = m_children.begin(); it != m_children.end(); it++ ) {
+		(*it)->addCodewordBits( bits );
+	}
 }
 
 #define min(a,b) (a<b) ? a : b
@@ -189,6 +229,11 @@ void FaultDomain::repair( uint64_t &n_undetectable, uint64_t &n_uncorrectable )
 	uint64_t faults_before_repair = getFaultCountPerm() + getFaultCountTrans();
 	n_undetectable = n_uncorrectable = faults_before_repair;
 
+	if( !needsRepair() ) {
+		n_undetectable = n_uncorrectable = 0;
+		return;
+	}
+
 	for( itr = m_repairSchemes.begin(); itr != m_repairSchemes.end(); itr++ ) {
 		uint64_t uncorrectable_after_repair = 0;
 		uint64_t undetectable_after_repair = 0;
@@ -217,6 +262,11 @@ void FaultDomain::repair( uint64_t &n_undetectable, uint64_t &n_uncorrectable )
 
 	//return n_uncorrectable;
 }
+bool FaultDomain::needsRepair( void )
+{
+	return true;
+}
+
 uint64_t FaultDomain::fill_repl( void )
 {
 	uint64_t n_uncorrectable = 0;
@@ -244,6 +294,10 @@ uint64_t FaultDomain::fill_repl( void )
 		n_errors_uncorrected++;
 	}
 
+	// faults retired into spares are gone, what is left is what the next scrub starts from
+	n_transient_ranges_scrubbed = getTransientRangeCount();
+	n_faults_permanent_filled = getFaultCountPerm();
+
 	return n_uncorrectable;
 }
 void FaultDomain::setFIT_TSV(bool isTransient_TSV, double FIT_TSV )
@@ -263,6 +317,35 @@ void FaultDomain::scrub( void )
 	for( it = m_children.begin(); it != m_children.end(); it++ ) {
 			(*it)->scrub();
 	}
+
+	// transient faults that are left could not be corrected and will never be scrubbed
+	n_transient_ranges_scrubbed = getTransientRangeCount();
+}
+
+uint64_t FaultDomain::getTransientRangeCount( void )
+{
+	uint64_t sum = 0;
+
+	list<FaultDomain*>::iterator it;
+
+	for( it = m_children.begin(); it != m_children.end(); it++ ) {
+		sum += (*it)->getTransientRangeCount();
+	}
+
+	return sum;
+}
+
+bool FaultDomain::needsScrub( void )
+{
+	if( getTransientRangeCount() > n_transient_ranges_scrubbed ) return true;
+
+	list<RepairScheme*>::iterator itr;
+
+	for( itr = m_repairSchemes.begin(); itr != m_repairSchemes.end(); itr++ ) {
+		if( (*itr)->retiresFaults() ) return getFaultCountPerm() > n_faults_permanent_filled;
+	}
+
+	return false;
 }
 
 uint64_t FaultDomain::getFailedSimCount( void )
@@ -312,6 +395,7 @@ void FaultDomain::finalize( void )
 	list<RepairScheme*>::iterator itr;
 	for( itr = m_repairSchemes.begin(); itr != m_repairSchemes.end(); itr++ ){
 	(*itr)->clear_counters();
+	(*itr)->resetSpares();
 	}
 	
 }
@@ -336,6 +420,11 @@ void FaultDomain::printStats( void )
 	     << " rate_raw " << device_fail_rate << " FIT_raw " << FIT_raw
 	     << " rate_uncorr " << uncorrected_fail_rate << " FIT_uncorr " << FIT_uncorr
 	     << " rate_undet " << undetected_fail_rate << " FIT_undet " << FIT_undet << "\n";
+
+	list<RepairScheme*>::iterator itr;
+	for( itr = m_repairSchemes.begin(); itr != m_repairSchemes.end(); itr++ ) {
+		(*itr)->printStats();
+	}
 }
 
 void FaultDomain::resetStats( void )
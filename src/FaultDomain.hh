@@ -35,11 +35,24 @@ public:
 	uint64_t getFailedSimCount( void );
 
 	virtual int update(uint test_mode_t);	// perform one iteration ; Prashant: Changed the update to return a non-void value
+	// first interval at or after the current one in which this domain or its children insert a fault
+	virtual uint64_t getNextFaultInterval( void );
+	// move this domain and its children to an interval, skipping the ones in between
+	void setInterval( uint64_t interval );
 	virtual void repair( uint64_t &n_undetectable, uint64_t &n_uncorrectable );
+	// false if the repair schemes are known to find no uncorrectable or undetectable errors
+	virtual bool needsRepair( void );
 	virtual uint64_t fill_repl(void);
 	virtual void scrub( void );
+	// number of transient FaultRanges currently held by this domain and its children
+	virtual uint64_t getTransientRangeCount( void );
+	// does this domain hold transient faults that arrived since it was last scrubbed, or permanent
+	// faults that its repair schemes could retire into spares?
+	bool needsScrub( void );
 	void addDomain( FaultDomain *domain, uint32_t domaincounter);
 	void addRepair( RepairScheme *repair );
+	// a repair scheme of this domain or above queries faults over codewords of this many low address bits
+	virtual void addCodewordBits( uint32_t bits );
 	// set up before first simulation run
 	virtual void init( uint64_t interval, uint64_t sim_seconds, double m_fit_factor );
 	// accrue simulation-level statistics at end of each sim run
@@ -92,8 +105,11 @@ public:
 	uint64_t n_faults_permanent;
 	uint64_t n_errors_uncorrected;
 	uint64_t n_errors_undetected;
+	uint64_t n_transient_ranges_scrubbed;	// transient ranges that survived the last scrub
+	uint64_t n_faults_permanent_filled;	// permanent faults at the last fill_repl
 
 	uint64_t m_interval, m_sim_seconds, m_fit_factor;
+	uint64_t curr_interval;	// index of the next interval to be simulated by update()
 
 	// cross-simulation overall program run statistics
 	uint64_t stat_n_simulations, stat_n_failures, stat_n_failures_undetected, stat_n_failures_uncorrected;
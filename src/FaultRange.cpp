@@ -15,6 +15,16 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "DRAMDomain.hh"
 #include "FaultRange.hh"
 #include "dram_common.hh"
+#include "FaultRangeArena.hh"
+
+FaultRangeArena *FaultRange::arena = NULL;
+
+void *FaultRange::operator new( size_t size )
+{
+	if( arena == NULL ) arena = new FaultRangeArena( ARENA_CHUNK_BYTES, false );
+
+	return arena->allocate( size );
+}
 
 FaultRange::FaultRange( DRAMDomain *pDRAM ) :
 m_pDRAM(pDRAM)
@@ -17,6 +17,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include <list>
 
 class DRAMDomain;
+class FaultRangeArena;
 
 using namespace std;
 
@@ -24,6 +25,10 @@ class FaultRange
 {
 public:
 	FaultRange( DRAMDomain *pDRAM );
+	// FaultRanges live until the end of the simulation run, when the arena releases all of them
+	static void *operator new( size_t size );
+	static void operator delete( void *p ) {}
+	static FaultRangeArena *arena;
 	// does this FR intersect with the supplied FR?
 	bool intersects( FaultRange *fr );
 	// How many bits in any sym_bits-wide symbol could be faulty?
@@ -49,7 +54,6 @@ public:
 
 private:
 	bool intersectsSlow( FaultRange *fr );
-	list<FaultRange> m_children;	// 'smaller' ranges contained within this one
 };
 
 
@@ -0,0 +1,89 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "FaultRangeArena.hh"
+#include <iostream>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+FaultRangeArena::FaultRangeArena( size_t chunk_bytes, bool huge_pages )
+{
+	m_huge_pages = huge_pages;
+	m_chunk_bytes = huge_pages ? ARENA_HUGE_PAGE_BYTES : chunk_bytes;
+	m_curr_chunk = 0;
+	m_offset = 0;
+
+	m_chunks.push_back( newChunk() );
+}
+
+FaultRangeArena::~FaultRangeArena()
+{
+	for( uint32_t i = 0; i < m_chunks.size(); i++ ) {
+		if( m_huge_pages ) {
+			munmap( m_chunks[i], m_chunk_bytes );
+		} else {
+			free( m_chunks[i] );
+		}
+	}
+}
+
+char *FaultRangeArena::newChunk( void )
+{
+	void *chunk;
+
+	if( m_huge_pages ) {
+		// Prefer reserved huge pages, then fall back to transparent huge pages
+		chunk = mmap( NULL, m_chunk_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+		if( chunk == MAP_FAILED ) {
+			chunk = mmap( NULL, m_chunk_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+			if( chunk != MAP_FAILED ) madvise( chunk, m_chunk_bytes, MADV_HUGEPAGE );
+		}
+		if( chunk == MAP_FAILED ) chunk = NULL;
+	} else {
+		chunk = malloc( m_chunk_bytes );
+	}
+
+	if( chunk == NULL ) {
+		cout << "ERROR: FaultRangeArena out of memory\n";
+		exit(0);
+	}
+
+	return (char*)chunk;
+}
+
+void *FaultRangeArena::allocate( size_t bytes )
+{
+	// keep every object 16-byte aligned
+	bytes = ( bytes + 15 ) & ~((size_t)15);
+
+	if( m_offset + bytes > m_chunk_bytes ) {
+		m_curr_chunk++;
+		if( m_curr_chunk == m_chunks.size() ) m_chunks.push_back( newChunk() );
+		m_offset = 0;
+	}
+
+	void *p = m_chunks[m_curr_chunk] + m_offset;
+	m_offset += bytes;
+
+	return p;
+}
+
+void FaultRangeArena::release( void )
+{
+	m_curr_chunk = 0;
+	m_offset = 0;
+}
+
+uint64_t FaultRangeArena::getChunkCount( void )
+{
+	return m_chunks.size();
+}
@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef FAULTRANGEARENA_HH_
+#define FAULTRANGEARENA_HH_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+using namespace std;
+
+#define ARENA_CHUNK_BYTES (64*1024)			// default chunk size
+#define ARENA_HUGE_PAGE_BYTES (2*1024*1024)	// chunk size when backed by huge pages
+
+// Bump allocator for the FaultRanges of one simulation. Objects are never freed one by one,
+// all of them are released at once by release() when the simulation is reset. Chunks are
+// kept for reuse by the following simulations, so a steady-state simulation does not call malloc.
+
+class FaultRangeArena
+{
+	public:
+	FaultRangeArena( size_t chunk_bytes, bool huge_pages );
+	~FaultRangeArena();
+
+	void *allocate( size_t bytes );
+	void release( void );	// O(1), invalidates every object allocated so far
+
+	uint64_t getChunkCount( void );
+
+	protected:
+	char *newChunk( void );
+
+	vector<char*> m_chunks;
+	size_t m_chunk_bytes;
+	bool m_huge_pages;
+	uint32_t m_curr_chunk;	// chunk being allocated from
+	size_t m_offset;		// next free byte within the current chunk
+};
+
+
+#endif /* FAULTRANGEARENA_HH_ */
@@ -0,0 +1,757 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "FaultStore.hh"
+#include "FaultRange.hh"
+#include "DRAMDomain.hh"
+#include "IntersectKernel.hh"
+#include <algorithm>
+
+FaultStore::FaultStore( DRAMDomain *pDRAM ) :
+m_pDRAM(pDRAM)
+, m_n_points(0)
+, m_n_bank_wild(0)
+, m_row_shift(0)
+, m_bank_shift(0)
+, m_rank_shift(0)
+, m_n_ranks(1)
+, m_n_banks(1)
+, m_word_bits(FAULTSTORE_WORD_BITS)
+, m_indexed(false)
+, m_index_min(FAULTSTORE_INDEX_MIN)
+, m_points_min(FAULTSTORE_POINTS_QUERY_MIN)
+, m_generation(0)
+, m_coalesce(false)
+, m_epoch(1)
+{
+	clearBankWide();
+}
+
+void FaultStore::setKeyShifts( uint32_t row_shift, uint32_t bank_shift, uint32_t rank_shift, uint32_t addr_bits )
+{
+	m_row_shift = row_shift;
+	m_bank_shift = bank_shift;
+	m_rank_shift = rank_shift;
+	m_n_banks = 1 << ( rank_shift - bank_shift );
+	m_n_ranks = 1 << ( addr_bits - rank_shift );
+	m_indexed = false;
+	rebuildPoints();
+}
+
+uint32_t FaultStore::getRowShift( void )
+{
+	return m_row_shift;
+}
+
+uint32_t FaultStore::getBankShift( void )
+{
+	return m_bank_shift;
+}
+
+void FaultStore::setWordBits( uint32_t bits )
+{
+	if( bits <= m_word_bits ) return;
+
+	m_word_bits = bits;
+	rebuildPoints();
+}
+
+uint64_t FaultStore::getTSVStride( uint32_t i, uint32_t low_bits )
+{
+	if( !TSV[i] ) return 0;
+	return fWildMask[i] & ((1ULL << m_row_shift)-1) & ~((1ULL << low_bits)-1);
+}
+
+void FaultStore::setQueryMins( uint32_t index_min, uint32_t points_min )
+{
+	m_index_min = index_min;
+	m_points_min = points_min;
+}
+
+void FaultStore::setCoalescing( bool coalesce )
+{
+	m_coalesce = coalesce;
+}
+
+uint32_t FaultStore::getFoldedCount( void )
+{
+	return m_folded.size();
+}
+
+void FaultStore::Level::clear( void )
+{
+	key.clear();
+	fAddr.clear();
+	fWildMask.clear();
+	index.clear();
+}
+
+void FaultStore::Level::insert( uint64_t key_t, uint64_t fAddr_t, uint64_t fWildMask_t, uint32_t index_t )
+{
+	// after all faults with the same key, which have lower indices
+	uint32_t pos = upper_bound( key.begin(), key.end(), key_t ) - key.begin();
+
+	key.insert( key.begin() + pos, key_t );
+	fAddr.insert( fAddr.begin() + pos, fAddr_t );
+	fWildMask.insert( fWildMask.begin() + pos, fWildMask_t );
+	index.insert( index.begin() + pos, index_t );
+}
+
+void FaultStore::Level::append( uint64_t key_t, uint64_t fAddr_t, uint64_t fWildMask_t, uint32_t index_t )
+{
+	key.push_back( key_t );
+	fAddr.push_back( fAddr_t );
+	fWildMask.push_back( fWildMask_t );
+	index.push_back( index_t );
+}
+
+struct LevelKeyLess
+{
+	const vector<uint64_t> &key;
+	LevelKeyLess( const vector<uint64_t> &key_t ) : key( key_t ) {}
+	bool operator()( uint32_t a, uint32_t b ) const { return key[a] < key[b]; }
+};
+
+void FaultStore::Level::sort( void )
+{
+	// faults are appended in index order, a stable sort keeps ties that way
+	vector<uint32_t> order( key.size() );
+	for( uint32_t p = 0; p < order.size(); p++ ) order[p] = p;
+	stable_sort( order.begin(), order.end(), LevelKeyLess( key ) );
+
+	Level sorted;
+	for( uint32_t p = 0; p < order.size(); p++ ) {
+		sorted.append( key[order[p]], fAddr[order[p]], fWildMask[order[p]], index[order[p]] );
+	}
+	swap( key, sorted.key );
+	swap( fAddr, sorted.fAddr );
+	swap( fWildMask, sorted.fWildMask );
+	swap( index, sorted.index );
+}
+
+void FaultStore::Level::remap( const vector<uint32_t> &to )
+{
+	// compaction keeps the order of the faults, so the level stays sorted
+	uint32_t j = 0;
+	for( uint32_t p = 0; p < index.size(); p++ ) {
+		if( to[index[p]] == FAULTSTORE_NO_INDEX ) continue;
+		key[j] = key[p];
+		fAddr[j] = fAddr[p];
+		fWildMask[j] = fWildMask[p];
+		index[j] = to[index[p]];
+		j++;
+	}
+	key.resize( j );
+	fAddr.resize( j );
+	fWildMask.resize( j );
+	index.resize( j );
+}
+
+static inline uint32_t pointSlot( uint64_t key, uint32_t n_slots )
+{
+	// Fibonacci hashing, n_slots is a power of two
+	return ( key * 0x9E3779B97F4A7C15ULL ) >> 32 & ( n_slots - 1 );
+}
+
+void FaultStore::addPoint( uint32_t i )
+{
+	addBankWide( i );
+
+	if( ( fWildMask[i] >> m_word_bits ) != 0 ) {
+		m_ranges.key.push_back( 0 );
+		m_ranges.fAddr.push_back( fAddr[i] );
+		m_ranges.fWildMask.push_back( fWildMask[i] );
+		m_ranges.index.push_back( i );
+		if( ( fWildMask[i] >> m_bank_shift ) != 0 ) m_n_bank_wild++;
+		return;
+	}
+
+	// keep the table at most half full
+	if( 2 * ( m_n_points + 1 ) > m_pointIndex.size() ) {
+		uint32_t n_slots = max( (uint32_t)FAULTSTORE_POINTS_MIN, (uint32_t)m_pointIndex.size() * 2 );
+		vector<uint32_t> indices( m_pointIndex );
+
+		m_pointKey.assign( n_slots, 0 );
+		m_pointIndex.assign( n_slots, FAULTSTORE_NO_INDEX );
+		m_n_points = 0;
+		for( uint32_t s = 0; s < indices.size(); s++ ) {
+			if( indices[s] != FAULTSTORE_NO_INDEX ) addPoint( indices[s] );
+		}
+	}
+
+	uint64_t key = fAddr[i] >> m_word_bits;
+	uint32_t s = pointSlot( key, m_pointIndex.size() );
+	while( m_pointIndex[s] != FAULTSTORE_NO_INDEX ) s = ( s + 1 ) & ( m_pointIndex.size() - 1 );
+
+	m_pointKey[s] = key;
+	m_pointIndex[s] = i;
+	m_n_points++;
+}
+
+void FaultStore::rebuildPoints( void )
+{
+	fill( m_pointIndex.begin(), m_pointIndex.end(), FAULTSTORE_NO_INDEX );
+	m_n_points = 0;
+	m_n_bank_wild = 0;
+	m_ranges.clear();
+	clearBankWide();
+	for( uint32_t i = 0; i < size(); i++ ) addPoint( i );
+}
+
+void FaultStore::clearBankWide( void )
+{
+	m_bankWide.assign( m_n_ranks * m_n_banks, 0 );
+	m_rankWide.assign( m_n_ranks, 0 );
+	m_n_chip_wide = 0;
+	m_n_all_bank_wide = 0;
+	m_otherBankWide.clear();
+}
+
+void FaultStore::addBankWide( uint32_t i )
+{
+	uint64_t below_bank = ( 1ULL << m_bank_shift ) - 1;
+	if( max_faults[i] == 0 || ( fWildMask[i] & below_bank ) != below_bank ) return;
+
+	uint32_t rank = fAddr[i] >> m_rank_shift & ( m_n_ranks - 1 );
+	uint32_t bank = fAddr[i] >> m_bank_shift & ( m_n_banks - 1 );
+	uint32_t wild_rank = fWildMask[i] >> m_rank_shift & ( m_n_ranks - 1 );
+	uint32_t wild_bank = fWildMask[i] >> m_bank_shift & ( m_n_banks - 1 );
+
+	if( wild_rank == m_n_ranks - 1 && wild_bank == m_n_banks - 1 ) {
+		m_n_chip_wide++;
+	} else if( wild_rank == 0 && wild_bank == m_n_banks - 1 ) {
+		m_rankWide[rank]++;
+	} else if( wild_rank == 0 && wild_bank == 0 ) {
+		m_bankWide[rank * m_n_banks + bank]++;
+	} else {
+		m_otherBankWide.push_back( i );
+	}
+	m_n_all_bank_wide++;
+}
+
+// The ranks and banks the range is in are the values of its fields under its wild bits, usually one each
+
+bool FaultStore::anyBankWide( uint64_t addr, uint64_t mask )
+{
+	if( m_n_all_bank_wide == 0 ) return false;
+	if( m_n_chip_wide != 0 ) return true;
+
+	uint32_t rank = addr >> m_rank_shift & ( m_n_ranks - 1 );
+	uint32_t bank = addr >> m_bank_shift & ( m_n_banks - 1 );
+	uint32_t wild_rank = mask >> m_rank_shift & ( m_n_ranks - 1 );
+	uint32_t wild_bank = mask >> m_bank_shift & ( m_n_banks - 1 );
+
+	if( wild_rank == 0 && wild_bank == 0 ) {
+		if( m_rankWide[rank] != 0 || m_bankWide[rank * m_n_banks + bank] != 0 ) return true;
+	} else {
+		for( uint32_t r = 0; r < m_n_ranks; r++ ) {
+			if( ( ( r ^ rank ) & ~wild_rank ) != 0 ) continue;
+			if( m_rankWide[r] != 0 ) return true;
+			for( uint32_t b = 0; b < m_n_banks; b++ ) {
+				if( ( ( b ^ bank ) & ~wild_bank ) == 0 && m_bankWide[r * m_n_banks + b] != 0 ) return true;
+			}
+		}
+	}
+
+	for( uint32_t k = 0; k < m_otherBankWide.size(); k++ ) {
+		if( intersects( m_otherBankWide[k], addr, mask ) ) return true;
+	}
+	return false;
+}
+
+// Point faults in the ECC word of the query that intersect it. Stops at the first one if out is NULL.
+
+bool FaultStore::probePoints( uint64_t addr, uint64_t mask, bool untouched_only, vector<uint32_t> *out )
+{
+	if( m_n_points == 0 ) return false;
+
+	uint64_t key = addr >> m_word_bits;
+	uint32_t n_slots = m_pointIndex.size();
+	bool found = false;
+
+	for( uint32_t s = pointSlot( key, n_slots ); m_pointIndex[s] != FAULTSTORE_NO_INDEX; s = ( s + 1 ) & ( n_slots - 1 ) ) {
+		uint32_t j = m_pointIndex[s];
+		if( m_pointKey[s] != key || !intersects( j, addr, mask ) ) continue;
+		if( untouched_only && !untouched( j ) ) continue;
+
+		found = true;
+		if( out == NULL ) break;
+		out->push_back( j );
+	}
+
+	return found;
+}
+
+// findIntersecting() for a query within one ECC word: the lower of the first matching range
+// and the first matching point fault
+
+int64_t FaultStore::findInWord( uint64_t addr, uint64_t mask, bool untouched_only, uint32_t start )
+{
+	int64_t first = -1;
+
+	// ranges are few and the wide ones match most queries, so they usually end the search early
+	uint32_t n = m_ranges.index.size();
+	uint32_t i = lower_bound( m_ranges.index.begin(), m_ranges.index.end(), start ) - m_ranges.index.begin();
+	while( i < n ) {
+		int64_t found = intersectFirst( &m_ranges.fAddr[i], &m_ranges.fWildMask[i], n - i, addr, mask );
+		if( found < 0 ) break;
+
+		i += found;
+		uint32_t j = m_ranges.index[i];
+		if( !untouched_only || untouched( j ) ) {
+			first = j;
+			break;
+		}
+		i++;
+	}
+
+	if( m_n_points != 0 ) {
+		uint64_t key = addr >> m_word_bits;
+		uint32_t n_slots = m_pointIndex.size();
+
+		for( uint32_t s = pointSlot( key, n_slots ); m_pointIndex[s] != FAULTSTORE_NO_INDEX; s = ( s + 1 ) & ( n_slots - 1 ) ) {
+			uint32_t j = m_pointIndex[s];
+			if( m_pointKey[s] != key || j < start || ( first != -1 && j > first ) ) continue;
+			if( !intersects( j, addr, mask ) ) continue;
+			if( untouched_only && !untouched( j ) ) continue;
+			first = j;
+		}
+	}
+
+	return first;
+}
+
+// Whether fault j contains the range and may be its parent. Of two identical faults the one with the
+// lower index is the parent, and faults on their way out of the arrays are no parents.
+
+bool FaultStore::canContain( uint32_t j, uint64_t addr, uint64_t mask, uint32_t self )
+{
+	if( j == self || max_faults[j] == 0 || TSV[j] ) return false;
+	if( ( mask & ~fWildMask[j] ) != 0 || ( ( addr ^ fAddr[j] ) & ~fWildMask[j] ) != 0 ) return false;
+	if( fWildMask[j] == mask && j > self ) return false;
+	return m_fate.empty() || m_fate[j] != FAULTSTORE_REMOVED;
+}
+
+int64_t FaultStore::findContaining( uint64_t addr, uint64_t mask, uint32_t self )
+{
+	// a containing fault intersects the range, so only intersecting faults are candidates
+	uint32_t n = m_ranges.index.size();
+	uint32_t i = 0;
+	while( i < n ) {
+		int64_t found = intersectFirst( &m_ranges.fAddr[i], &m_ranges.fWildMask[i], n - i, addr, mask );
+		if( found < 0 ) break;
+
+		i += found;
+		if( canContain( m_ranges.index[i], addr, mask, self ) ) return m_ranges.index[i];
+		i++;
+	}
+
+	// only a point fault can contain another one
+	if( ( mask >> m_word_bits ) == 0 ) {
+		m_candidates.clear();
+		probePoints( addr, mask, false, &m_candidates );
+		for( uint32_t c = 0; c < m_candidates.size(); c++ ) {
+			if( canContain( m_candidates[c], addr, mask, self ) ) return m_candidates[c];
+		}
+	}
+
+	return -1;
+}
+
+void FaultStore::indexFault( uint32_t i, bool append )
+{
+	Level *level = &m_wide;
+	uint64_t key = 0;
+
+	if( ( fWildMask[i] >> m_row_shift ) == 0 ) {
+		level = &m_rows;
+		key = fAddr[i] >> m_row_shift;
+	} else if( ( fWildMask[i] >> m_bank_shift ) == 0 ) {
+		level = &m_banks;
+		key = fAddr[i] >> m_bank_shift;
+	}
+
+	if( append ) {
+		level->append( key, fAddr[i], fWildMask[i], i );
+	} else {
+		level->insert( key, fAddr[i], fWildMask[i], i );
+	}
+}
+
+void FaultStore::reindex( void )
+{
+	m_rows.clear();
+	m_banks.clear();
+	m_wide.clear();
+	for( uint32_t i = 0; i < size(); i++ ) indexFault( i, true );
+	m_rows.sort();
+	m_banks.sort();
+	m_indexed = true;
+}
+
+uint32_t FaultStore::insert( FaultRange *fr )
+{
+	// a fault inside one that is already known changes no query result, keep it aside
+	if( m_coalesce && fr->max_faults != 0 && !fr->TSV ) {
+		int64_t p = findContaining( fr->fAddr, fr->fWildMask, FAULTSTORE_NO_INDEX );
+		if( p != -1 ) {
+			m_folded.push_back( *fr );
+			m_foldedParent.push_back( p );
+			return p;
+		}
+	}
+
+	fAddr.push_back( fr->fAddr );
+	fWildMask.push_back( fr->fWildMask );
+	max_faults.push_back( fr->max_faults );
+	m_touched.push_back( fr->touched );
+	m_touchedEpoch.push_back( fr->touched ? m_epoch : 0 );
+	transient.push_back( fr->transient );
+	TSV.push_back( fr->TSV );
+	transient_remove.push_back( fr->transient_remove );
+	timestamp.push_back( fr->timestamp );
+
+	uint32_t i = fAddr.size() - 1;
+	addPoint( i );
+	if( m_indexed ) indexFault( i, false );
+	return i;
+}
+
+void FaultStore::clear( void )
+{
+	// most chips see no fault in a simulation; an empty store has nothing to forget, and keeping
+	// its generation spares the repair schemes a rebuild of their state
+	if( size() == 0 && m_folded.empty() ) return;
+
+	// keeps the capacity for the next simulation
+	fAddr.clear();
+	fWildMask.clear();
+	max_faults.clear();
+	m_touched.clear();
+	m_touchedEpoch.clear();
+	transient.clear();
+	TSV.clear();
+	transient_remove.clear();
+	timestamp.clear();
+
+	m_rows.clear();
+	m_banks.clear();
+	m_wide.clear();
+	m_indexed = false;
+
+	fill( m_pointIndex.begin(), m_pointIndex.end(), FAULTSTORE_NO_INDEX );
+	m_n_points = 0;
+	m_n_bank_wild = 0;
+	m_ranges.clear();
+	clearBankWide();
+
+	m_folded.clear();
+	m_foldedParent.clear();
+
+	scrubbed.clear();
+	scrubbedAddr.clear();
+	scrubbedWildMask.clear();
+	m_generation++;
+}
+
+uint64_t FaultStore::scrub( void )
+{
+	uint32_t n = size();
+	uint64_t n_removed = 0;
+
+	// folded faults are scrubbed by the same rule as the others, whatever happens to their parent
+	uint32_t k = 0;
+	for( uint32_t f = 0; f < m_folded.size(); f++ ) {
+		if( m_folded[f].transient && m_folded[f].transient_remove ) {
+			n_removed++;
+			continue;
+		}
+		m_folded[k] = m_folded[f];
+		m_foldedParent[k] = m_foldedParent[f];
+		k++;
+	}
+	m_folded.resize( k, FaultRange( m_pDRAM ) );
+	m_foldedParent.resize( k );
+
+	// decide which faults leave the arrays: scrubbed transients, and the faults contained in one that stays
+	m_fate.assign( n, FAULTSTORE_NO_INDEX );
+	for( uint32_t i = 0; i < n; i++ ) {
+		if( transient[i] && transient_remove[i] ) {
+			m_fate[i] = FAULTSTORE_REMOVED;
+			n_removed++;
+		}
+	}
+	if( m_coalesce ) {
+		for( uint32_t i = 0; i < n; i++ ) {
+			if( m_fate[i] != FAULTSTORE_NO_INDEX || max_faults[i] == 0 || TSV[i] ) continue;
+			int64_t p = findContaining( fAddr[i], fWildMask[i], i );
+			if( p != -1 ) m_fate[i] = p;
+		}
+	}
+
+	compact();
+	return n_removed;
+}
+
+// Take the faults at the given indices out of the store, as a scrub would
+
+void FaultStore::remove( const vector<uint32_t> &indices )
+{
+	if( indices.empty() ) return;
+
+	m_fate.assign( size(), FAULTSTORE_NO_INDEX );
+	for( uint32_t r = 0; r < indices.size(); r++ ) m_fate[indices[r]] = FAULTSTORE_REMOVED;
+	compact();
+}
+
+// Compact the arrays in place, keeping the order of the remaining faults. m_fate holds what
+// happens to each fault: it stays, is removed, or is folded under a parent.
+
+void FaultStore::compact( void )
+{
+	uint32_t n = size();
+	vector<uint32_t> remap( n, FAULTSTORE_NO_INDEX );
+	uint32_t j = 0;
+	bool logged = false;
+
+	for( uint32_t i = 0; i < n; i++ ) {
+		if( m_fate[i] != FAULTSTORE_NO_INDEX ) {
+			// a new removal log replaces the one of the previous generation
+			if( !logged ) {
+				scrubbed.clear();
+				scrubbedAddr.clear();
+				scrubbedWildMask.clear();
+				logged = true;
+			}
+			scrubbed.push_back( i );
+			scrubbedAddr.push_back( fAddr[i] );
+			scrubbedWildMask.push_back( fWildMask[i] );
+
+			if( m_fate[i] != FAULTSTORE_REMOVED ) {
+				// containment is transitive, fold under the outermost fault that stays
+				uint32_t p = m_fate[i];
+				while( m_fate[p] != FAULTSTORE_NO_INDEX ) p = m_fate[p];
+				m_folded.push_back( get( i ) );
+				m_foldedParent.push_back( p );
+			}
+			continue;
+		}
+
+		remap[i] = j;
+		if( i != j ) {
+			fAddr[j] = fAddr[i];
+			fWildMask[j] = fWildMask[i];
+			max_faults[j] = max_faults[i];
+			m_touched[j] = m_touched[i];
+			m_touchedEpoch[j] = m_touchedEpoch[i];
+			transient[j] = transient[i];
+			TSV[j] = TSV[i];
+			transient_remove[j] = transient_remove[i];
+			timestamp[j] = timestamp[i];
+		}
+		j++;
+	}
+
+	fAddr.resize( j );
+	fWildMask.resize( j );
+	max_faults.resize( j );
+	m_touched.resize( j );
+	m_touchedEpoch.resize( j );
+	transient.resize( j );
+	TSV.resize( j );
+	transient_remove.resize( j );
+	timestamp.resize( j );
+	m_fate.clear();
+
+	// the remaining faults have moved
+	if( j != n ) {
+		if( m_indexed ) {
+			m_rows.remap( remap );
+			m_banks.remap( remap );
+			m_wide.remap( remap );
+		}
+		rebuildPoints();
+		m_generation++;
+	}
+
+	// follow the parents to their new index, faults whose parent was removed are restored
+	vector<FaultRange> orphans;
+	uint32_t k = 0;
+	for( uint32_t f = 0; f < m_folded.size(); f++ ) {
+		if( remap[m_foldedParent[f]] == FAULTSTORE_NO_INDEX ) {
+			orphans.push_back( m_folded[f] );
+			continue;
+		}
+		m_folded[k] = m_folded[f];
+		m_foldedParent[k] = remap[m_foldedParent[f]];
+		k++;
+	}
+	m_folded.resize( k, FaultRange( m_pDRAM ) );
+	m_foldedParent.resize( k );
+
+	for( uint32_t f = 0; f < orphans.size(); f++ ) insert( &orphans[f] );
+}
+
+void FaultStore::clearTouched( void )
+{
+	// the stamps are rewritten before the epoch comes around again
+	if( ++m_epoch == 0 ) {
+		fill( m_touchedEpoch.begin(), m_touchedEpoch.end(), 0 );
+		m_epoch = 1;
+	}
+}
+
+void FaultStore::setEpoch( uint32_t epoch )
+{
+	m_epoch = epoch;
+}
+
+int64_t FaultStore::findIntersecting( uint64_t addr, uint64_t mask, bool untouched_only, uint32_t start )
+{
+	if( usePoints( mask ) ) return findInWord( addr, mask, untouched_only, start );
+
+	uint32_t n = size();
+	uint32_t i = start;
+
+	// the batch kernel finds the next intersecting fault, skip it if it has been used up
+	while( i < n ) {
+		int64_t found = intersectFirst( &fAddr[i], &fWildMask[i], n - i, addr, mask );
+		if( found < 0 ) return -1;
+
+		i += found;
+		if( !untouched_only || untouched( i ) ) return i;
+		i++;
+	}
+
+	return -1;
+}
+
+// Faults of the level with key_lo <= key < key_hi that intersect the range. Stops at the first one
+// if out is NULL.
+
+bool FaultStore::scanLevel( Level &level, uint64_t key_lo, uint64_t key_hi, uint64_t addr, uint64_t mask, bool untouched_only, vector<uint32_t> *out )
+{
+	uint32_t i = 0;
+	uint32_t hi = level.key.size();
+	bool found_any = false;
+
+	// the whole level needs no search
+	if( key_lo != 0 || key_hi != UINT64_MAX ) {
+		i = lower_bound( level.key.begin(), level.key.end(), key_lo ) - level.key.begin();
+		hi = lower_bound( level.key.begin() + i, level.key.end(), key_hi ) - level.key.begin();
+	}
+
+	while( i < hi ) {
+		int64_t found = intersectFirst( &level.fAddr[i], &level.fWildMask[i], hi - i, addr, mask );
+		if( found < 0 ) break;
+
+		i += found;
+		uint32_t j = level.index[i];
+		if( !untouched_only || untouched( j ) ) {
+			found_any = true;
+			if( out == NULL ) break;
+			out->push_back( j );
+		}
+		i++;
+	}
+
+	return found_any;
+}
+
+// Faults that intersect the range, from the levels of the index it can meet: the wide list, and
+// the faults in its bank and row (or in all of them, for a query with wild rank or bank bits).
+// Stops at the first one if out is NULL.
+
+bool FaultStore::queryIndex( uint64_t addr, uint64_t mask, bool untouched_only, vector<uint32_t> *out )
+{
+	if( !m_indexed ) reindex();
+
+	// wide faults are the most likely to intersect, so try them first
+	bool found = scanLevel( m_wide, 0, UINT64_MAX, addr, mask, untouched_only, out );
+	if( found && out == NULL ) return true;
+
+	if( ( mask >> m_bank_shift ) != 0 ) {
+		// wild rank or bank bits, every fault is a candidate
+		found |= scanLevel( m_banks, 0, UINT64_MAX, addr, mask, untouched_only, out );
+		if( found && out == NULL ) return true;
+		return scanLevel( m_rows, 0, UINT64_MAX, addr, mask, untouched_only, out ) || found;
+	}
+
+	uint64_t bank_key = addr >> m_bank_shift;
+	found |= scanLevel( m_banks, bank_key, bank_key + 1, addr, mask, untouched_only, out );
+	if( found && out == NULL ) return true;
+
+	if( ( mask >> m_row_shift ) != 0 ) {
+		// wild row bits, every row of the bank is a candidate
+		uint32_t row_bits = m_bank_shift - m_row_shift;
+		return scanLevel( m_rows, bank_key << row_bits, ( bank_key + 1 ) << row_bits, addr, mask, untouched_only, out ) || found;
+	}
+
+	uint64_t row_key = addr >> m_row_shift;
+	return scanLevel( m_rows, row_key, row_key + 1, addr, mask, untouched_only, out ) || found;
+}
+
+bool FaultStore::anyIntersecting( uint64_t addr, uint64_t mask, bool untouched_only )
+{
+	// a query within one ECC word can only meet the point faults of that word
+	if( usePoints( mask ) ) {
+		return scanLevel( m_ranges, 0, UINT64_MAX, addr, mask, untouched_only, NULL )
+				|| probePoints( addr, mask, untouched_only, NULL );
+	}
+
+	if( size() < m_index_min ) return findIntersecting( addr, mask, untouched_only ) != -1;
+	return queryIndex( addr, mask, untouched_only, NULL );
+}
+
+uint64_t FaultStore::getGeneration( void )
+{
+	return m_generation;
+}
+
+void FaultStore::collectIntersecting( uint64_t addr, uint64_t mask, vector<uint32_t> &out )
+{
+	if( usePoints( mask ) ) {
+		probePoints( addr, mask, false, &out );
+		scanLevel( m_ranges, 0, UINT64_MAX, addr, mask, false, &out );
+		return;
+	}
+
+	if( size() >= m_index_min ) {
+		queryIndex( addr, mask, false, &out );
+		return;
+	}
+
+	for( int64_t i = findIntersecting( addr, mask, false ); i != -1; i = findIntersecting( addr, mask, false, i + 1 ) ) {
+		out.push_back( i );
+	}
+}
+
+FaultRange FaultStore::get( uint32_t i )
+{
+	FaultRange fr( m_pDRAM );
+
+	fr.fAddr = fAddr[i];
+	fr.fWildMask = fWildMask[i];
+	fr.max_faults = max_faults[i];
+	fr.touched = getTouched( i );
+	fr.transient = transient[i];
+	fr.TSV = TSV[i];
+	fr.transient_remove = transient_remove[i];
+	fr.timestamp = timestamp[i];
+
+	return fr;
+}
+
+string FaultStore::toString( uint32_t i )
+{
+	return get( i ).toString();
+}
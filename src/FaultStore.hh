@@ -0,0 +1,265 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef FAULTSTORE_HH_
+#define FAULTSTORE_HH_
+
+#include "boost/cstdint.hpp"
+#include <vector>
+#include <string>
+#include "FaultRange.hh"
+
+class DRAMDomain;
+
+using namespace std;
+
+// The FaultRanges of one chip, stored as contiguous arrays of their fields (structure of arrays)
+// so that the intersection scans of the repair schemes stream through dense memory. A fault is
+// identified by its index, which stays valid until the next scrub() or clear(). Faults are kept
+// in insertion order.
+//
+// Faults whose wild bits all lie within one ECC word (single bit and single word faults, most of
+// the FIT budget) are also kept in an open-addressing hash table keyed by the word address, and
+// the remaining ranges in a separate list. A query within one ECC word probes the table and only
+// scans the ranges, once the store is large enough for this to beat a scan of all faults. The word
+// is the widest codeword the repair schemes of the module project faults onto, so the table keys
+// are their projected keys, computed once at insertion.
+//
+// With coalescing, a fault contained in another one of the chip (its wild bits a subset, and equal
+// in the other bits) is folded under that parent and kept out of the arrays, as it cannot change
+// whether a query intersects the chip. Folded faults are scrubbed by the usual rule, and restored
+// to the arrays when their parent is scrubbed.
+//
+// Faults are also indexed by the address fields they fix. Faults with fixed rank, bank and row are
+// sorted on that prefix, faults with a wild row but fixed rank and bank on the rank/bank prefix, and
+// the rest (wild rank or bank) are kept in a small wide list. An existence query then only probes
+// its own row, its own bank and the wide list. The index is built by the first query that needs it,
+// and kept up to date through insertions and removals from then on.
+//
+// Faults covering whole banks (every bit below the bank wild: bank, multi-bank and whole-chip
+// faults) intersect every query in their banks. They are also counted per bank, per rank and for
+// the whole chip, so that a scheme can tell in constant time that a chip meets a query before it
+// looks at the finer faults.
+
+#define FAULTSTORE_INDEX_MIN 512	// below this many faults a scan of all faults is faster than the index (see check/IndexCheck)
+#define FAULTSTORE_WORD_BITS 3		// least address bits within one ECC word (an 8-bit symbol of a x4 chip)
+#define FAULTSTORE_POINTS_MIN 16	// initial number of point table slots
+#define FAULTSTORE_POINTS_QUERY_MIN 128	// below this many faults a scan of all faults is as fast as the point table (see check/PointCheck)
+#define FAULTSTORE_NO_INDEX 0xffffffff
+#define FAULTSTORE_REMOVED 0xfffffffe
+
+#define FAULTQUERY_TRANSIENT 0x1
+#define FAULTQUERY_TSV 0x2
+
+// A fault as a plain value, for the queries a repair scheme derives from it (rounded to a symbol,
+// one block of a TSV stride, ...). Unlike a FaultRange it can be copied without allocating.
+struct FaultQuery
+{
+	uint64_t addr, mask;	// address, and bit positions that are wildcards
+	uint64_t max_faults;
+	uint32_t flags;	// FAULTQUERY_*
+};
+
+class FaultStore
+{
+public:
+	FaultStore( DRAMDomain *pDRAM );
+
+	// address bits below the row, the bank and the rank fields, and in the whole address; used as index keys
+	void setKeyShifts( uint32_t row_shift, uint32_t bank_shift, uint32_t rank_shift, uint32_t addr_bits );
+	uint32_t getRowShift( void );
+	uint32_t getBankShift( void );
+
+	// widen the ECC word of the point table to a codeword of this many low address bits
+	void setWordBits( uint32_t bits );
+
+	// store sizes from which queries go through the index and the point table, FAULTSTORE_INDEX_MIN
+	// and FAULTSTORE_POINTS_QUERY_MIN unless changed (by the checks, to force or rule out either one)
+	void setQueryMins( uint32_t index_min, uint32_t points_min );
+
+	// fold faults contained in another one (only valid for schemes that ask whether faults intersect)
+	void setCoalescing( bool coalesce );
+
+	uint32_t insert( FaultRange *fr );	// copy a FaultRange into the store, returns its index (or the index of its parent)
+	uint32_t size( void );
+	void clear( void );
+	uint64_t scrub( void );	// remove transient faults that may be removed and fold contained ones, returns the number removed
+	void remove( const vector<uint32_t> &indices );	// remove the faults at these indices (in any order)
+	// Each repair call starts by setting touched to zero for all faults. The counters carry the
+	// epoch they were last written in, and read as zero in any other, so this only starts a new epoch.
+	void clearTouched( void );
+	void setEpoch( uint32_t epoch );	// for the checks, to reach the wrap-around of the epochs quickly (not 0)
+	uint64_t getTouched( uint32_t i );
+	void touch( uint32_t i );	// touched++
+	bool untouched( uint32_t i );	// touched < max_faults
+
+	// first fault at or after index start that intersects the given range, or -1.
+	// untouched_only skips faults with touched >= max_faults.
+	int64_t findIntersecting( uint64_t addr, uint64_t mask, bool untouched_only, uint32_t start = 0 );
+	bool intersects( uint32_t i, uint64_t addr, uint64_t mask );
+	// whether any fault intersects the given range, using the point table or the index
+	bool anyIntersecting( uint64_t addr, uint64_t mask, bool untouched_only );
+	// append every fault intersecting the given range to out, in no particular order
+	void collectIntersecting( uint64_t addr, uint64_t mask, vector<uint32_t> &out );
+	bool anyIntersecting( const FaultQuery &q, bool untouched_only );
+	void collectIntersecting( const FaultQuery &q, vector<uint32_t> &out );
+	// whether a fault with max_faults set that covers whole banks intersects the range, whatever
+	// their touched values
+	bool anyBankWide( uint64_t addr, uint64_t mask );
+
+	// wild column/bit address bits at or above low_bits of a TSV fault; each value of them is a
+	// separate set of faulty bits that a scheme looking at one block at a time must visit on its own
+	uint64_t getTSVStride( uint32_t i, uint32_t low_bits );
+
+	FaultRange get( uint32_t i );	// copy of a fault as a FaultRange
+	FaultQuery getQuery( uint32_t i );
+	string toString( uint32_t i );
+	uint32_t getFoldedCount( void );
+
+	// Change tracking for repair schemes that keep state across calls. Faults are only ever appended
+	// between removals, and the generation changes whenever faults are removed. A scrub that removes
+	// faults also records what it removed, so that a scheme one generation behind can catch up.
+	uint64_t getGeneration( void );
+	vector<uint32_t> scrubbed;	// indices (before the scrub, increasing) of the faults the last scrub removed or folded
+	vector<uint64_t> scrubbedAddr, scrubbedWildMask;
+
+	// one entry per fault
+	vector<uint64_t> fAddr, fWildMask;	// address of faulty range, and bit positions that are wildcards (all values)
+	vector<uint64_t> max_faults;
+	vector<uint8_t> transient, TSV, transient_remove;
+	vector<double> timestamp;	// time in seconds at which the fault was inserted (event-driven simulation)
+
+	DRAMDomain *m_pDRAM;
+
+private:
+	// faults of one index level sorted on key (ties in index order), as contiguous arrays
+	struct Level
+	{
+		vector<uint64_t> key;
+		vector<uint64_t> fAddr, fWildMask;
+		vector<uint32_t> index;
+
+		void clear( void );
+		void insert( uint64_t key, uint64_t fAddr, uint64_t fWildMask, uint32_t index );
+		void append( uint64_t key, uint64_t fAddr, uint64_t fWildMask, uint32_t index );	// out of order, until sort()
+		void sort( void );
+		void remap( const vector<uint32_t> &to );	// follow compact(), dropping the faults it removed
+	};
+
+	bool canContain( uint32_t j, uint64_t addr, uint64_t mask, uint32_t self );
+	int64_t findContaining( uint64_t addr, uint64_t mask, uint32_t self );
+
+	void addPoint( uint32_t i );
+	void rebuildPoints( void );	// rebuild the point table and range list from scratch
+	void compact( void );	// drop or fold the faults as m_fate says, keeping the order of the others
+	bool probePoints( uint64_t addr, uint64_t mask, bool untouched_only, vector<uint32_t> *out );
+	int64_t findInWord( uint64_t addr, uint64_t mask, bool untouched_only, uint32_t start );
+
+	void indexFault( uint32_t i, bool append );	// append leaves the level unsorted
+	void reindex( void );	// build the index from scratch, it is then kept up to date until clear()
+	bool scanLevel( Level &level, uint64_t key_lo, uint64_t key_hi, uint64_t addr, uint64_t mask, bool untouched_only, vector<uint32_t> *out );
+	bool queryIndex( uint64_t addr, uint64_t mask, bool untouched_only, vector<uint32_t> *out );
+
+	// point faults by word address, linear probing, an empty slot has index FAULTSTORE_NO_INDEX
+	vector<uint64_t> m_pointKey;
+	vector<uint32_t> m_pointIndex;
+	uint32_t m_n_points;
+	Level m_ranges;	// the other faults, in index order
+	uint32_t m_n_bank_wild;	// ranges with wild bank or rank bits, they meet most queries early in a scan
+	bool usePoints( uint64_t mask );
+
+	uint32_t m_row_shift, m_bank_shift, m_rank_shift;
+	uint32_t m_n_ranks, m_n_banks;	// values of the rank and bank fields
+
+	// faults covering whole banks: per rank and bank, per rank (all banks wild), whole chip (rank
+	// and banks wild), and the few with only some rank or bank bits wild
+	void addBankWide( uint32_t i );
+	void clearBankWide( void );
+	vector<uint32_t> m_bankWide, m_rankWide;
+	uint32_t m_n_chip_wide, m_n_all_bank_wide;
+	vector<uint32_t> m_otherBankWide;
+	uint32_t m_word_bits;	// address bits within one ECC word, the point table is keyed on the bits above
+	Level m_rows, m_banks, m_wide;
+	bool m_indexed;	// the index is up to date, it is only built once a query needs it
+	uint32_t m_index_min, m_points_min;	// see setQueryMins()
+	uint64_t m_generation;
+
+	bool m_coalesce;
+	vector<FaultRange> m_folded;	// faults folded under a parent, hidden from queries
+	vector<uint32_t> m_foldedParent;
+	vector<uint32_t> m_fate;	// during scrub() and remove(), per fault: stays, FAULTSTORE_REMOVED, or the parent it folds under
+	vector<uint32_t> m_candidates;
+
+	// per fault, touched count and the epoch it belongs to
+	vector<uint64_t> m_touched;
+	vector<uint32_t> m_touchedEpoch;
+	uint32_t m_epoch;	// current epoch, never 0 so that a zero stamp is always stale
+};
+
+// size(), intersects() and the touched counters are used in the innermost loops of the repair schemes, keep them inline
+
+inline uint32_t FaultStore::size( void )
+{
+	return fAddr.size();
+}
+
+inline uint64_t FaultStore::getTouched( uint32_t i )
+{
+	return m_touchedEpoch[i] == m_epoch ? m_touched[i] : 0;
+}
+
+inline void FaultStore::touch( uint32_t i )
+{
+	m_touched[i] = getTouched( i ) + 1;
+	m_touchedEpoch[i] = m_epoch;
+}
+
+inline bool FaultStore::untouched( uint32_t i )
+{
+	return getTouched( i ) < max_faults[i];
+}
+
+// The point table pays off for queries within one ECC word of large stores, unless a bank-wide
+// range would end a plain scan early anyway
+
+inline bool FaultStore::usePoints( uint64_t mask )
+{
+	return ( mask >> m_word_bits ) == 0 && size() >= m_points_min && m_n_bank_wild == 0;
+}
+
+inline bool FaultStore::intersects( uint32_t i, uint64_t addr, uint64_t mask )
+{
+	return ( ~( mask | fWildMask[i] ) & ( addr ^ fAddr[i] ) ) == 0;
+}
+
+inline bool FaultStore::anyIntersecting( const FaultQuery &q, bool untouched_only )
+{
+	return anyIntersecting( q.addr, q.mask, untouched_only );
+}
+
+inline void FaultStore::collectIntersecting( const FaultQuery &q, vector<uint32_t> &out )
+{
+	collectIntersecting( q.addr, q.mask, out );
+}
+
+inline FaultQuery FaultStore::getQuery( uint32_t i )
+{
+	FaultQuery q;
+	q.addr = fAddr[i];
+	q.mask = fWildMask[i];
+	q.max_faults = max_faults[i];
+	q.flags = ( transient[i] ? FAULTQUERY_TRANSIENT : 0 ) | ( TSV[i] ? FAULTQUERY_TSV : 0 );
+	return q;
+}
+
+
+#endif /* FAULTSTORE_HH_ */
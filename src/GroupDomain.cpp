@@ -11,7 +11,10 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 */
 
 #include "GroupDomain.hh"
+#include "DRAMDomain.hh"
+#include "RepairScheme.hh"
 #include <iostream>
+#include <algorithm>
 #include <stdlib.h>
 
 GroupDomain::GroupDomain( const char *name ) : FaultDomain( name )
@@ -20,5 +23,138 @@ GroupDomain::GroupDomain( const char *name ) : FaultDomain( name )
 	tsv_permanentFIT=0;
 	tsv_n_faults_transientFIT_class=0;
 	tsv_n_faults_permanentFIT_class=0;
+
+	m_clean = true;
+	m_n_wide = 0;
+	m_row_shift = m_bank_shift = 0;
+	stat_n_repairs = stat_n_skipped = 0;
+}
+
+void GroupDomain::repair( uint64_t &n_undetectable, uint64_t &n_uncorrectable )
+{
+	FaultDomain::repair( n_undetectable, n_uncorrectable );
+	m_clean = ( n_undetectable == 0 && n_uncorrectable == 0 );
+}
+
+// Bring the occupancy summary up to date with the faults of all chips and decide whether the
+// repair schemes need to run
+
+bool GroupDomain::needsRepair( void )
+{
+	stat_n_repairs++;
+
+	if( m_repairSchemes.empty() ) return true;
+
+	// removed faults cannot be taken out of a Bloom filter, start over after a scrub
+	bool changed = ( m_known.size() != m_children.size() );
+	uint32_t c = 0;
+	list<FaultDomain*>::iterator it;
+	for( it = m_children.begin(); !changed && it != m_children.end(); it++, c++ ) {
+		DRAMDomain *pDRAM = dynamic_cast<DRAMDomain*>((*it));
+		if( pDRAM->getRanges()->getGeneration() != m_generation[c] ) changed = true;
+	}
+	if( changed ) clearOccupancy();
+
+	// after a rebuild every fault is new, so the outcome of the last repair does not matter
+	bool skip = m_clean || changed;
+	bool any_new = false;
+	c = 0;
+	for( it = m_children.begin(); it != m_children.end(); it++, c++ ) {
+		FaultStore *pRange = dynamic_cast<DRAMDomain*>((*it))->getRanges();
+
+		for( uint32_t i = m_known[c]; i < pRange->size(); i++ ) {
+			any_new = true;
+			if( !addOccupancy( pRange, i ) ) skip = false;
+
+			list<RepairScheme*>::iterator itr;
+			for( itr = m_repairSchemes.begin(); skip && itr != m_repairSchemes.end(); itr++ ) {
+				if( !(*itr)->isolatedCorrectable( pRange->fWildMask[i], m_row_shift ) ) skip = false;
+			}
+		}
+		m_known[c] = pRange->size();
+	}
+
+	if( skip && any_new ) {
+		stat_n_skipped++;
+		return false;
+	}
+	return true;
+}
+
+void GroupDomain::clearOccupancy( void )
+{
+	m_known.assign( m_children.size(), 0 );
+	m_generation.assign( m_children.size(), 0 );
+
+	uint32_t c = 0;
+	list<FaultDomain*>::iterator it;
+	for( it = m_children.begin(); it != m_children.end(); it++, c++ ) {
+		DRAMDomain *pDRAM = dynamic_cast<DRAMDomain*>((*it));
+		m_generation[c] = pDRAM->getRanges()->getGeneration();
+		if( c == 0 ) {
+			m_row_shift = pDRAM->getRanges()->getRowShift();
+			m_bank_shift = pDRAM->getRanges()->getBankShift();
+			m_bank_faults.assign( 1 << (pDRAM->getLogRanks() + pDRAM->getLogBanks()), 0 );
+			m_bank_wild_rows.assign( m_bank_faults.size(), 0 );
+		}
+	}
+
+	m_n_wide = 0;
+	fill( m_bank_faults.begin(), m_bank_faults.end(), 0 );
+	fill( m_bank_wild_rows.begin(), m_bank_wild_rows.end(), 0 );
+	m_row_bloom.assign( OCCUPANCY_BLOOM_BITS / 64, 0 );
+}
+
+bool GroupDomain::addOccupancy( FaultStore *pRange, uint32_t i )
+{
+	uint64_t fAddr = pRange->fAddr[i];
+	uint64_t fWildMask = pRange->fWildMask[i];
+
+	if( ( fWildMask >> m_bank_shift ) != 0 ) {
+		m_n_wide++;
+		return false;
+	}
+
+	uint64_t bank = fAddr >> m_bank_shift;
+	bool isolated = ( m_n_wide == 0 && m_bank_wild_rows[bank] == 0 );
+	m_bank_faults[bank]++;
+
+	if( ( fWildMask >> m_row_shift ) != 0 ) {
+		m_bank_wild_rows[bank]++;
+		return isolated && m_bank_faults[bank] == 1;
+	}
+
+	// two probes into the filter from one multiplicative hash of rank, bank and row
+	uint64_t hash = ( fAddr >> m_row_shift ) * 0x9E3779B97F4A7C15ULL;
+	uint32_t h0 = ( hash >> 32 ) % OCCUPANCY_BLOOM_BITS;
+	uint32_t h1 = ( hash & 0xffffffff ) % OCCUPANCY_BLOOM_BITS;
+	bool seen = ( m_row_bloom[h0 / 64] >> (h0 % 64) & 1 ) && ( m_row_bloom[h1 / 64] >> (h1 % 64) & 1 );
+	m_row_bloom[h0 / 64] |= 1ULL << (h0 % 64);
+	m_row_bloom[h1 / 64] |= 1ULL << (h1 % 64);
+
+	return isolated && !seen;
+}
+
+void GroupDomain::reset( void )
+{
+	FaultDomain::reset();
+	m_clean = true;
+	m_known.clear();
+}
+
+void GroupDomain::printStats( void )
+{
+	FaultDomain::printStats();
+
+	if( stat_n_repairs != 0 ) {
+		cout << "[" << m_name << ".prefilter] repairs " << stat_n_repairs << " skipped " << stat_n_skipped
+		     << " skip_rate " << ((double)stat_n_skipped)/((double)stat_n_repairs) << "\n";
+	}
+}
+
+void GroupDomain::resetStats( void )
+{
+	FaultDomain::resetStats();
+	stat_n_repairs = stat_n_skipped = 0;
 }
 
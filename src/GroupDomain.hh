@@ -14,6 +14,17 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #define GROUPDOMAIN_HH_
 
 #include "FaultDomain.hh"
+#include <vector>
+
+#define OCCUPANCY_BLOOM_BITS 8192	// bits of the Bloom filter over the rows holding faults
+
+class FaultStore;
+
+// A module keeps a coarse summary of where the faults of all its chips are: how many have a wild
+// rank or bank, how many fix their rank and bank (and of those, how many have a wild row) per
+// rank and bank, and a Bloom filter over the rows of the others. When every fault that arrived
+// since the last repair shares no row with any other fault, and the last repair found no errors,
+// the repair schemes can tell without evaluating the module that it is still free of errors.
 
 class GroupDomain : public FaultDomain
 {
@@ -22,6 +33,26 @@ class GroupDomain : public FaultDomain
 	virtual void setFIT(){};
 	virtual void init(){};
 	virtual void update(){};
+
+	void repair( uint64_t &n_undetectable, uint64_t &n_uncorrectable );
+	bool needsRepair( void );
+	void reset( void );
+	void printStats( void );
+	void resetStats( void );
+
+	protected:
+	void clearOccupancy( void );
+	bool addOccupancy( FaultStore *pRange, uint32_t i );	// returns whether the fault was isolated
+
+	bool m_clean;	// the last repair found no uncorrectable or undetectable errors
+	vector<uint32_t> m_known;	// per chip, faults covered by the summary
+	vector<uint64_t> m_generation;	// per chip, FaultStore generation the summary was built from
+	uint32_t m_n_wide;	// faults with wild rank or bank bits
+	vector<uint32_t> m_bank_faults, m_bank_wild_rows;	// per rank and bank
+	vector<uint64_t> m_row_bloom;
+	uint32_t m_row_shift, m_bank_shift;
+
+	uint64_t stat_n_repairs, stat_n_skipped;
 };
 
 
@@ -28,6 +28,7 @@ GroupDomain_cube::GroupDomain_cube( const char *name, uint cube_model_t, uint64_
 	cube_addr_dec_depth=cube_addr_dec_depth_t; //Address Decoding Depth
 	//Check if TSVs need to be enabled for Fault Modelling
 	enable_tsv=enable_tsv_t;
+	next_tsv_valid=false;
 	//Params to figure out the number of TSVs in the chip
 	chips=chips_t;
 	banks=banks_t;
@@ -109,44 +110,88 @@ GroupDomain_cube::GroupDomain_cube( const char *name, uint cube_model_t, uint64_
 int GroupDomain_cube::update( uint test_mode_t )
 {
 	int newfault = 0;
-	uint64_t location=0;
 	//Check if TSVs are enabled
 	if(enable_tsv)
 	{	
+		if( !next_tsv_valid ) drawNextTSVFaults();
+
 		// determine whether any faults happened.
-		// if so, record them.
-		double random = gen();
-		if( random <= tsv_transientFIT) {
-			// only record un-correctable faults for overall simulation success determination
-			tsv_n_faults_transientFIT_class++;
+		// if so, record them and draw the interval of the next one.
+		if( next_tsv_interval[0] == curr_interval ) {
+			genTSVFault( true );
 			newfault = 1;
-			//Record the fault and update the info for TSV
-			location = eng()%total_tsv;
-			if(tsv_bitmap[location]==false)
-			{
-				tsv_bitmap[location]=true;
-				tsv_info[location]=1;
-			}
+			next_tsv_interval[0] = geometricNext( curr_interval + 1, gen(), tsv_transientFIT );
 		}
-		random = gen();
-		if( random <= tsv_permanentFIT) {
-			// only record un-correctable faults for overall simulation success determination
-			tsv_n_faults_permanentFIT_class++;
+		if( next_tsv_interval[1] == curr_interval ) {
+			genTSVFault( false );
 			newfault = 1;
-			//Record the fault in a tsv and update its info
-			location = eng()%total_tsv;
-			if(tsv_bitmap[location]==false)
-			{
-				tsv_bitmap[location]=true;
-				tsv_info[location]=2;
-			}
+			next_tsv_interval[1] = geometricNext( curr_interval + 1, gen(), tsv_permanentFIT );
 		}
 	}
-	FaultDomain::update(test_mode_t);
+	if( FaultDomain::update(test_mode_t) ) {
+		newfault = 1;
+	}
+
+	curr_interval++;
 	
 	return newfault;
 }
 
+uint64_t GroupDomain_cube::getNextFaultInterval( void )
+{
+	uint64_t next = FaultDomain::getNextFaultInterval();
+
+	if( enable_tsv ) {
+		if( !next_tsv_valid ) drawNextTSVFaults();
+
+		if( next_tsv_interval[0] < next ) next = next_tsv_interval[0];
+		if( next_tsv_interval[1] < next ) next = next_tsv_interval[1];
+	}
+
+	return next;
+}
+
+void GroupDomain_cube::drawNextTSVFaults( void )
+{
+	next_tsv_interval[0] = geometricNext( curr_interval, gen(), tsv_transientFIT );
+	next_tsv_interval[1] = geometricNext( curr_interval, gen(), tsv_permanentFIT );
+	next_tsv_valid = true;
+}
+
+int64_t GroupDomain_cube::genTSVFault( bool isTransient )
+{
+	// only record un-correctable faults for overall simulation success determination
+	if( isTransient ) {
+		tsv_n_faults_transientFIT_class++;
+	} else {
+		tsv_n_faults_permanentFIT_class++;
+	}
+
+	//Record the fault in a tsv and update its info. The DRAMDomain owning the TSV
+	//expands it into FaultRanges the next time updateTSV() is called on it
+	uint64_t location = eng()%total_tsv;
+	if(tsv_bitmap[location]==false)
+	{
+		tsv_bitmap[location]=true;
+		tsv_info[location]=isTransient ? 2 : 1;
+		return location;
+	}
+
+	return -1;
+}
+
+void GroupDomain_cube::reset( void )
+{
+	// TSV failures only last for the simulation they occurred in
+	for( uint64_t ii = 0; ii < total_tsv; ii++ ) {
+		tsv_bitmap[ii] = false;
+		tsv_info[ii] = 0;
+	}
+	next_tsv_valid = false;
+
+	GroupDomain::reset();
+}
+
 void GroupDomain_cube::setFIT( int faultClass, bool isTransient, double FIT )
 {
 	assert(0);
@@ -161,6 +206,10 @@ void GroupDomain_cube::init( uint64_t interval, uint64_t max_s, double fit_facto
 	m_sim_seconds = max_s;
 	m_fit_factor = fit_factor;
 
+	// For Event Driven sim (transient followed by permanent, as in DRAMDomain)
+	hrs_per_fault_tsv[0] = ((double)1000000000.0) / (tsv_transientFIT * fit_factor);
+	hrs_per_fault_tsv[1] = ((double)1000000000.0) / (tsv_permanentFIT * fit_factor);
+
 	double sec_per_hour = 60 * 60;
 	double interval_factor = (interval / sec_per_hour) / 1000000000.0;
 	tsv_transientFIT = (double)1.0 - exp( -tsv_transientFIT * fit_factor * interval_factor );
@@ -31,13 +31,26 @@ class GroupDomain_cube : public GroupDomain
 	void setFIT( int faultClass, bool isTransient, double FIT );
 	void init( uint64_t interval, uint64_t max_s, double fit_factor );
 	int update( uint test_mode_t );	// perform one iteration
+	uint64_t getNextFaultInterval( void );
+	void reset( void );
 	void setFIT_TSV(bool isTransient_TSV, double FIT_TSV );
-	protected:
-	void generateRanges( int faultClass ); // based on a fault, create all faulty address ranges
-	
+	// fail a random TSV, returns its location or -1 if it had already failed
+	int64_t genTSVFault( bool isTransient );
+
+	// Parameters for event-driven simulation (hours per TSV fault transient followed by permanent)
+	double hrs_per_fault_tsv[2];
+
 	ENG  eng;
 	DIST dist;
 	GEN  gen;
+
+	protected:
+	void generateRanges( int faultClass ); // based on a fault, create all faulty address ranges
+	void drawNextTSVFaults( void );
+
+	// For interval-based simulation: next interval with a TSV fault (transient followed by permanent)
+	uint64_t next_tsv_interval[2];
+	bool next_tsv_valid;	// next_tsv_interval has been drawn for this simulation
 };
 
 
@@ -0,0 +1,175 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "IntersectKernel.hh"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define INTERSECT_X86
+#include <immintrin.h>
+#endif
+
+static int64_t intersectFirstSelect( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask );
+
+// Starts out pointing at a selector, which replaces it with the best kernel for this CPU
+IntersectFirstKernel intersectFirst = intersectFirstSelect;
+static const char *kernel_name = "scalar";
+
+// Two ranges intersect if every address bit is either wild in one of them or equal in both
+
+int64_t intersectFirstScalar( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask )
+{
+	for( uint32_t i = 0; i < n; i++ ) {
+		if( ( ~( qMask | mask[i] ) & ( qAddr ^ addr[i] ) ) == 0 ) return i;
+	}
+
+	return -1;
+}
+
+// A range covers the locations that agree with its address outside its wild bits. Within a word
+// of the bitmap, each wild bit k doubles the set by copying it 2^k locations up; the wild bits
+// above the word select which words get that pattern.
+
+void blockCoverage( uint64_t addr, uint64_t mask, uint32_t bits, uint64_t *bitmap )
+{
+	uint32_t word_bits = bits < 6 ? bits : 6;
+	uint64_t word_mask = ( (uint64_t)1 << word_bits ) - 1;
+
+	uint64_t pattern = (uint64_t)1 << ( addr & ~mask & word_mask );
+	for( uint32_t k = 0; k < word_bits; k++ ) {
+		if( ( mask >> k ) & 1 ) pattern |= pattern << ( 1 << k );
+	}
+
+	if( bits <= 6 ) {
+		bitmap[0] |= pattern;
+		return;
+	}
+
+	uint64_t upper = ( (uint64_t)1 << ( bits - 6 ) ) - 1;
+	uint64_t wAddr = ( addr >> 6 ) & ~( mask >> 6 ) & upper;
+	uint64_t wMask = ( mask >> 6 ) & upper;
+	uint64_t sub = 0;
+	do {
+		bitmap[wAddr | sub] |= pattern;
+		sub = ( sub - wMask ) & wMask;
+	} while( sub != 0 );
+}
+
+#ifdef INTERSECT_X86
+
+// Lanes of the result are all ones where the candidate intersects the query
+__attribute__((target("avx2")))
+static inline __m256i intersectAVX2( const uint64_t *addr, const uint64_t *mask, __m256i vAddr, __m256i vMask )
+{
+	__m256i a = _mm256_loadu_si256( (const __m256i *)addr );
+	__m256i m = _mm256_loadu_si256( (const __m256i *)mask );
+	__m256i diff = _mm256_andnot_si256( _mm256_or_si256( m, vMask ), _mm256_xor_si256( a, vAddr ) );
+	return _mm256_cmpeq_epi64( diff, _mm256_setzero_si256() );
+}
+
+__attribute__((target("avx2")))
+int64_t intersectFirstAVX2( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask )
+{
+	const __m256i vAddr = _mm256_set1_epi64x( qAddr );
+	const __m256i vMask = _mm256_set1_epi64x( qMask );
+	uint32_t i = 0;
+
+	// 8 candidates per iteration
+	for( ; i + 8 <= n; i += 8 ) {
+		__m256i hit0 = intersectAVX2( addr + i, mask + i, vAddr, vMask );
+		__m256i hit1 = intersectAVX2( addr + i + 4, mask + i + 4, vAddr, vMask );
+		uint32_t hits = _mm256_movemask_pd( _mm256_castsi256_pd( hit0 ) ) | ( _mm256_movemask_pd( _mm256_castsi256_pd( hit1 ) ) << 4 );
+		if( hits != 0 ) return i + __builtin_ctz( hits );
+	}
+
+	int64_t tail = intersectFirstScalar( addr + i, mask + i, n - i, qAddr, qMask );
+	return ( tail < 0 ) ? -1 : i + tail;
+}
+
+// Bit i of the result is set where candidate i of 8 intersects the query, valid masks off the tail
+__attribute__((target("avx512f")))
+static inline __mmask8 intersectAVX512( const uint64_t *addr, const uint64_t *mask, __m512i vAddr, __m512i vMask, __mmask8 valid )
+{
+	__m512i a = _mm512_maskz_loadu_epi64( valid, addr );
+	__m512i m = _mm512_maskz_loadu_epi64( valid, mask );
+	// ~(m | vMask) & (a ^ vAddr) in one instruction, 0x02 is the truth table of ~A & ~B & C
+	__m512i diff = _mm512_ternarylogic_epi64( m, vMask, _mm512_xor_si512( a, vAddr ), 0x02 );
+	return _mm512_mask_testn_epi64_mask( valid, diff, diff );
+}
+
+__attribute__((target("avx512f")))
+int64_t intersectFirstAVX512( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask )
+{
+	const __m512i vAddr = _mm512_set1_epi64( qAddr );
+	const __m512i vMask = _mm512_set1_epi64( qMask );
+	uint32_t i = 0;
+
+	// 16 candidates per iteration
+	for( ; i + 16 <= n; i += 16 ) {
+		uint32_t hits = intersectAVX512( addr + i, mask + i, vAddr, vMask, 0xFF )
+				| ( intersectAVX512( addr + i + 8, mask + i + 8, vAddr, vMask, 0xFF ) << 8 );
+		if( hits != 0 ) return i + __builtin_ctz( hits );
+	}
+
+	for( ; i < n; i += 8 ) {
+		__mmask8 valid = ( n - i >= 8 ) ? 0xFF : (__mmask8)( ( 1 << ( n - i ) ) - 1 );
+		uint32_t hits = intersectAVX512( addr + i, mask + i, vAddr, vMask, valid );
+		if( hits != 0 ) return i + __builtin_ctz( hits );
+	}
+
+	return -1;
+}
+
+#else
+
+int64_t intersectFirstAVX2( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask )
+{
+	return intersectFirstScalar( addr, mask, n, qAddr, qMask );
+}
+
+int64_t intersectFirstAVX512( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask )
+{
+	return intersectFirstScalar( addr, mask, n, qAddr, qMask );
+}
+
+#endif
+
+static void selectKernels( void )
+{
+#ifdef INTERSECT_X86
+	__builtin_cpu_init();
+	if( __builtin_cpu_supports( "avx512f" ) ) {
+		intersectFirst = intersectFirstAVX512;
+		kernel_name = "avx512";
+		return;
+	}
+	if( __builtin_cpu_supports( "avx2" ) ) {
+		intersectFirst = intersectFirstAVX2;
+		kernel_name = "avx2";
+		return;
+	}
+#endif
+	intersectFirst = intersectFirstScalar;
+	kernel_name = "scalar";
+}
+
+static int64_t intersectFirstSelect( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask )
+{
+	selectKernels();
+	return intersectFirst( addr, mask, n, qAddr, qMask );
+}
+
+const char *intersectKernelName( void )
+{
+	if( intersectFirst == intersectFirstSelect ) selectKernels();
+	return kernel_name;
+}
@@ -0,0 +1,42 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef INTERSECTKERNEL_HH_
+#define INTERSECTKERNEL_HH_
+
+#include "boost/cstdint.hpp"
+
+// Batch intersection of one query range against n candidate ranges stored as contiguous
+// address and wildcard-mask arrays (see FaultStore).
+//
+// intersectFirst returns the index of the first candidate that intersects the query, or -1.
+//
+// An AVX-512, AVX2 or scalar implementation is selected at runtime from the features of the
+// host CPU the first time it is called. make check compares them (see check/IntersectCheck.cpp).
+
+typedef int64_t (*IntersectFirstKernel)( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask );
+
+extern IntersectFirstKernel intersectFirst;
+
+int64_t intersectFirstScalar( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask );
+int64_t intersectFirstAVX2( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask );
+int64_t intersectFirstAVX512( const uint64_t *addr, const uint64_t *mask, uint32_t n, uint64_t qAddr, uint64_t qMask );
+
+const char *intersectKernelName( void );	// name of the implementation in use
+
+// Locations of an aligned block of 2^bits addresses covered by the range (addr, mask), ORed into a
+// bitmap with bit l%64 of word l/64 set for location l. Only the low bits of the range are looked
+// at, so it must already be known to meet the block.
+void blockCoverage( uint64_t addr, uint64_t mask, uint32_t bits, uint64_t *bitmap );
+
+#endif /* INTERSECTKERNEL_HH_ */
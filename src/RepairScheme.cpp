@@ -11,24 +11,55 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 */
 
 #include "RepairScheme.hh"
+#include "Sparing.hh"
 
 RepairScheme::RepairScheme( string name )
 {
 	m_name = name;
+	m_sparing = NULL;
 
 	resetStats();
 }
 
 uint64_t RepairScheme::fill_repl (FaultDomain *fd)
 {
-	return 1;
+	if( m_sparing != NULL ) m_sparing->retire( fd );
+	return 0;
 }
+
+void RepairScheme::setSparing( Sparing *sparing )
+{
+	m_sparing = sparing;
+}
+
+bool RepairScheme::retiresFaults( void )
+{
+	return m_sparing != NULL;
+}
+
+void RepairScheme::resetSpares( void )
+{
+	if( m_sparing != NULL ) m_sparing->reset();
+}
+
+bool RepairScheme::isolatedCorrectable( uint64_t fWildMask, uint32_t row_shift )
+{
+	return false;
+}
+
+uint32_t RepairScheme::getCodewordBits( void )
+{
+	return 0;
+}
+
 void RepairScheme::printStats( void )
 {
+	if( m_sparing != NULL ) m_sparing->printStats( m_name );
 }
 
 void RepairScheme::resetStats( void )
 {
+	if( m_sparing != NULL ) m_sparing->resetStats();
 }
 
 string RepairScheme::getName( void )
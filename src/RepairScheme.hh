@@ -16,6 +16,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include <list>
 #include <string>
 #include "FaultDomain.hh"
+class Sparing;
 
 class RepairScheme
 {
@@ -24,14 +25,27 @@ public:
 	string getName( void );
 
 	virtual void repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t &n_uncorrectable ) = 0;
+	// called after every scrub, retires permanent faults into the spares if the scheme has any
 	virtual uint64_t fill_repl (FaultDomain *fd);
 	virtual void clear_counters (void)=0;
-
-	void printStats( void );
-	void resetStats( void );
+	void setSparing( Sparing *sparing );
+	bool retiresFaults( void );
+	void resetSpares( void );	// restore the spares at the end of a simulation
+	// Would a fault with this wildcard mask, sharing no row with any other fault of the module, leave
+	// a verdict without uncorrectable or undetectable errors unchanged, without touching any scheme
+	// or fault state? row_shift is the number of address bits below the row.
+	virtual bool isolatedCorrectable( uint64_t fWildMask, uint32_t row_shift );
+	// Low address bits of the codeword (or symbol) the scheme queries a fault over, i.e. the bits it
+	// makes wild when projecting a fault onto its codewords. The chips key their point faults on the
+	// address above these bits, so that the queries of the scheme are hash table probes.
+	virtual uint32_t getCodewordBits( void );
+
+	virtual void printStats( void );
+	virtual void resetStats( void );
 
 protected:
 	string m_name;
+	Sparing *m_sparing;	// NULL without sparing
 };
 
 
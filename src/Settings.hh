@@ -10,12 +10,16 @@ Redistribution and use in source and binary forms, with or without modification,
 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <string>
+#include "dram_common.hh"
+
 class Settings
 {
 public:
 	// Simulator settings
-	int sim_mode;		 // Interval or Event based
+	int sim_mode;		 // Interval or Event based, or chosen automatically
 	std::string output_file;      // Output results file
+	bool dry_run;		// Only print the predicted run time
 	uint64_t interval_s; // Simulation interval (seconds)
 	uint64_t scrub_s;    // Scrubbing interval (seconds)
 	uint64_t max_s;      // Simulation total duration (seconds)
@@ -25,9 +29,11 @@ public:
 	int verbose;			// Enable or disable runtime output
 	bool debug; 			// TODO document
 	uint64_t output_bucket_s; // Seconds per output histogram bucket
+	bool huge_pages;		// Back the FaultRange arena with huge pages
 
 	// Memory system physical configuration
 	int organization;	// Which topology to simulate e.g. DIMM or 3D stack
+	uint modules;		// Number of identical modules (DIMMs or stacks) in the system
 	// Settings for all DRAMs
 	uint chips_per_rank, chip_bus_bits, ranks, banks, rows, cols;
 
@@ -45,7 +51,16 @@ public:
 	bool enable_tsv;		// Enable TSV fault injection
 	bool enable_transient;	// Enable transient fault injection
 	bool enable_permanent;	// Enable permanent fault injection
+	// Age-dependent FIT rate profiles per fault class, empty for a constant rate (see FITProfile.hh)
+	std::string transient_profile[DRAM_MAX];
+	std::string permanent_profile[DRAM_MAX];
 
 	// ECC configuration
 	int repairmode;     // Type of ECC to apply
+	std::string ecc_layout;	// CodewordLayout of repairmode 6 (DIMM only)
+	uint ondie_sec_bits;	// Data bits per codeword of the on-die SEC code of every DRAM, 0 for none
+	// Spares that permanent faults are retired into at every scrub (see Sparing.hh)
+	uint spare_rows, spare_cols;	// per bank of each DRAM
+	uint spare_banks;	// per DRAM
+	uint spare_chips;	// per module
 };
@@ -13,6 +13,8 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "boost/cstdint.hpp"
 #include "Simulation.hh"
 #include "FaultDomain.hh"
+#include "FaultRange.hh"
+#include "FaultRangeArena.hh"
 #include <list>
 #include <iostream>
 #include <fstream>
@@ -61,6 +63,10 @@ void Simulation::reset( void )
 	for( it = m_domains.begin(); it != m_domains.end(); it++ ) {
 		(*it)->reset();
 	}
+
+	// No FaultRange of the previous run is referenced any more, including those
+	// an event-driven run generated but never inserted because it ended early
+	if( FaultRange::arena != NULL ) FaultRange::arena->release();
 }
 
 void Simulation::finalize( void )
@@ -92,12 +98,13 @@ void Simulation::simulate( uint64_t max_time, uint64_t n_sims, int verbose, std:
 	//Max time of simulation in seconds
 	stat_sim_seconds = max_time;
 
-	//Number of bins that the output file will have
-	fail_time_bins = new uint64_t[max_time/bin_length];
-	fail_uncorrectable = new uint64_t[max_time/bin_length];
-	fail_undetectable = new uint64_t[max_time/bin_length];
+	//Number of bins that the output file will have (the last one may cover a partial bucket)
+	uint64_t n_bins = (max_time + bin_length - 1)/bin_length;
+	fail_time_bins = new uint64_t[n_bins];
+	fail_uncorrectable = new uint64_t[n_bins];
+	fail_undetectable = new uint64_t[n_bins];
 
-	for( uint i = 0; i < max_time/bin_length; i++ )
+	for( uint i = 0; i < n_bins; i++ )
 	{
 		fail_time_bins[i] = 0;
 		fail_uncorrectable[i]=0;
@@ -158,7 +165,7 @@ void Simulation::simulate( uint64_t max_time, uint64_t n_sims, int verbose, std:
 	double p_undetected_cumulative = 0;
 	int64_t undetectable_cumulative = 0;
 
-	for(uint64_t jj=0;jj<max_time/bin_length;jj++)
+	for(uint64_t jj=0;jj<n_bins;jj++)
 	{
 		p_fail = ((double)fail_time_bins[jj])/n_sims;
 		p_uncorrected = ((double)fail_uncorrectable[jj])/n_sims;
@@ -177,6 +184,42 @@ void Simulation::simulate( uint64_t max_time, uint64_t n_sims, int verbose, std:
 }
 
 
+bool Simulation::scrub( void )
+{
+	list<FaultDomain*>::iterator it;
+
+	// Only domains holding transient faults that arrived since their last scrub need to be scrubbed
+	for( it = m_domains.begin(); it != m_domains.end(); it++ ) {
+		if( !(*it)->needsScrub() ) continue;
+
+		(*it)->scrub();
+
+		//User Defined Special operation to be performed while Scrubbing
+		if( (*it)->fill_repl() ) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint64_t Simulation::nextFaultIteration( uint64_t iter, uint64_t max_iterations )
+{
+	// Test modes insert faults in every iteration
+	if( test_mode != 0 ) return iter + 1;
+
+	uint64_t next_iter = max_iterations;
+	list<FaultDomain*>::iterator it;
+
+	for( it = m_domains.begin(); it != m_domains.end(); it++ ) {
+		uint64_t domain_next = (*it)->getNextFaultInterval();
+		if( domain_next < next_iter ) next_iter = domain_next;
+	}
+
+	assert( next_iter > iter );
+	return next_iter;
+}
+
 uint64_t Simulation::runOne( uint64_t max_s, int verbose, uint64_t bin_length)
 {
 	// returns number of uncorrectable simulations
@@ -194,7 +237,7 @@ uint64_t Simulation::runOne( uint64_t max_s, int verbose, uint64_t bin_length)
 	/*************************************************
 	 * THIS IS THE LOOP FOR A SINGLE RUN FOR N YEARS *
 	 *************************************************/
-	for( uint64_t iter = 0; iter < max_iterations; iter++ )
+	for( uint64_t iter = 0; iter < max_iterations; )
 	{
 		// loop through all fault domains and update
 		list<FaultDomain*>::iterator it;
@@ -267,16 +310,31 @@ uint64_t Simulation::runOne( uint64_t max_s, int verbose, uint64_t bin_length)
 
 		// Check if the time to scrub the domain has arrived
 		if( (iter % scrub_ratio) == 0 ) {
-			for( it = m_domains.begin(); it != m_domains.end(); it++ ) {
-				(*it)->scrub();
+			if( scrub() ) {
+				finalize();
+				return 1;
+			}
+		}
 
-				//User Defined Special operation to be performed while Scrubbing
-				if((*it)->fill_repl()){
+		// Skip ahead to the next iteration in which any domain inserts a fault. Nothing
+		// can fail in between, but one scrub must be done if a scrub time falls within
+		// the skipped iterations, so that transient faults are removed before the next fault.
+		uint64_t next_iter = nextFaultIteration( iter, max_iterations );
+
+		if( next_iter > iter + 1 ) {
+			if( ( iter / scrub_ratio + 1 ) * scrub_ratio < next_iter ) {
+				if( scrub() ) {
 					finalize();
 					return 1;
 				}
 			}
+
+			for( it = m_domains.begin(); it != m_domains.end(); it++ ) {
+				(*it)->setInterval( next_iter );
+			}
 		}
+
+		iter = next_iter;
 	}
 
 	/***********************************************/
@@ -29,6 +29,9 @@ public:
 	void printStats( void );	// output end-of-run stats
 
 protected:
+	bool scrub( void );	// scrub all domains, returns true if the simulation must halt
+	uint64_t nextFaultIteration( uint64_t iter, uint64_t max_iterations );
+
 	uint64_t m_interval;
 	uint64_t m_iteration;
 	uint64_t m_scrub_interval;
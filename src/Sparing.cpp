@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Sparing.hh"
+#include "DRAMDomain.hh"
+#include <iostream>
+
+Sparing::Sparing( uint32_t rows, uint32_t cols, uint32_t banks, uint32_t chips )
+: m_rows( rows )
+, m_cols( cols )
+, m_banks( banks )
+, m_chips( chips )
+{
+	reset();
+	resetStats();
+}
+
+void Sparing::reset( void )
+{
+	// the chips are set up again by the first retire() of the next simulation
+	m_chipSpares.clear();
+	m_chipsUsed = 0;
+}
+
+void Sparing::clearChip( ChipSpares &chip, uint32_t n_banks )
+{
+	chip.generation = 0;
+	chip.known = 0;
+	chip.rows.assign( n_banks, 0 );
+	chip.cols.assign( n_banks, 0 );
+	chip.banks = 0;
+}
+
+uint64_t Sparing::retire( FaultDomain *fd )
+{
+	list<FaultDomain*> *pChips = fd->getChildren();
+	uint64_t n_retired = 0;
+
+	if( m_chipSpares.size() != pChips->size() ) {
+		m_chipSpares.resize( pChips->size() );
+		uint32_t c = 0;
+		for( list<FaultDomain*>::iterator it = pChips->begin(); it != pChips->end(); it++, c++ ) {
+			DRAMDomain *pDRAM = dynamic_cast<DRAMDomain*>((*it));
+			clearChip( m_chipSpares[c], pDRAM->getRanks() * pDRAM->getBanks() );
+			m_chipSpares[c].generation = pDRAM->getRanges()->getGeneration();
+		}
+	}
+
+	uint32_t c = 0;
+	for( list<FaultDomain*>::iterator it = pChips->begin(); it != pChips->end(); it++, c++ ) {
+		DRAMDomain *pDRAM = dynamic_cast<DRAMDomain*>((*it));
+		FaultStore *pRange = pDRAM->getRanges();
+		ChipSpares &chip = m_chipSpares[c];
+
+		// budgets only shrink until the chip is spared, which takes all its faults, so a fault that
+		// found no spare before never will; only the faults that arrived since are looked at
+		uint32_t start = ( pRange->getGeneration() == chip.generation ) ? chip.known : 0;
+		if( start == pRange->size() ) continue;
+
+		m_retired.clear();
+		m_isRetired.assign( pRange->size(), 0 );
+		m_regionAddr.clear();
+		m_regionMask.clear();
+
+		for( uint32_t i = start; i < pRange->size(); i++ ) {
+			if( m_isRetired[i] || pRange->transient[i] || pRange->TSV[i] ) continue;
+			spare( pDRAM, chip, pRange->fAddr[i], pRange->fWildMask[i] );
+		}
+
+		while( !m_retired.empty() ) {
+			n_retired += m_retired.size();
+			pDRAM->retireRanges( m_retired );
+
+			// faults folded under a retired one are restored to the store, within the same region
+			collectRegions( pRange );
+		}
+
+		// so do the faults the on-die code was correcting within the regions
+		if( !m_regionAddr.empty() ) {
+			FaultStore *pOnDie = pDRAM->getOnDieRanges();
+			collectRegions( pOnDie );
+			n_retired += m_retired.size();
+			pOnDie->remove( m_retired );
+		}
+
+		chip.generation = pRange->getGeneration();
+		chip.known = pRange->size();
+	}
+
+	stat_n_retired += n_retired;
+	return n_retired;
+}
+
+// Take the smallest spare left that covers a permanent fault. The address is rank | bank | row | col | bit.
+
+bool Sparing::spare( DRAMDomain *pDRAM, ChipSpares &chip, uint64_t addr, uint64_t wild )
+{
+	uint32_t row_shift = pDRAM->getLogCols() + pDRAM->getLogBits();
+	uint32_t bank_shift = pDRAM->getLogRows() + row_shift;
+	uint64_t row_mask = ( 1ULL << row_shift ) - 1;	// bits within one row
+	uint64_t bank_mask = ( 1ULL << bank_shift ) - 1;	// bits within one bank
+	uint64_t col_mask = ( bank_mask & ~row_mask ) | ( ( 1ULL << pDRAM->getLogBits() ) - 1 );	// bits within one column
+	uint64_t b = addr >> bank_shift;	// rank and bank, if the fault is within one bank
+
+	if( ( wild & ~row_mask ) == 0 && chip.rows[b] < m_rows ) {
+		chip.rows[b]++;
+		stat_n_rows++;
+		take( pDRAM->getRanges(), addr & ~row_mask, row_mask );
+		return true;
+	}
+
+	if( ( wild & ~col_mask ) == 0 && chip.cols[b] < m_cols ) {
+		chip.cols[b]++;
+		stat_n_cols++;
+		take( pDRAM->getRanges(), addr & ~col_mask, col_mask );
+		return true;
+	}
+
+	// a whole bank or chip is not given up for a fault within one row or column
+	if( ( wild & ~row_mask ) == 0 || ( wild & ~col_mask ) == 0 ) return false;
+
+	if( ( wild & ~bank_mask ) == 0 && chip.banks < m_banks ) {
+		chip.banks++;
+		stat_n_banks++;
+		take( pDRAM->getRanges(), addr & ~bank_mask, bank_mask );
+		return true;
+	}
+
+	if( m_chipsUsed == m_chips ) return false;
+
+	m_chipsUsed++;
+	stat_n_chips++;
+	take( pDRAM->getRanges(), 0, ~0ULL );
+	clearChip( chip, chip.rows.size() );
+	return true;
+}
+
+void Sparing::take( FaultStore *pRange, uint64_t addr, uint64_t mask )
+{
+	m_regionAddr.push_back( addr );
+	m_regionMask.push_back( mask );
+	collect( pRange, addr, mask );
+}
+
+// every permanent fault of the store within a region (its wild bits a subset of the region's, and
+// equal in the others); transient faults are left to the scrub
+
+void Sparing::collect( FaultStore *pRange, uint64_t addr, uint64_t mask )
+{
+	for( uint32_t i = 0; i < pRange->size(); i++ ) {
+		if( m_isRetired[i] || pRange->transient[i] || pRange->TSV[i] ) continue;
+		if( ( pRange->fWildMask[i] & ~mask ) != 0 || ( ( pRange->fAddr[i] ^ addr ) & ~mask ) != 0 ) continue;
+
+		m_isRetired[i] = 1;
+		m_retired.push_back( i );
+	}
+}
+
+void Sparing::collectRegions( FaultStore *pRange )
+{
+	m_retired.clear();
+	m_isRetired.assign( pRange->size(), 0 );
+	for( uint32_t r = 0; r < m_regionAddr.size(); r++ ) collect( pRange, m_regionAddr[r], m_regionMask[r] );
+}
+
+void Sparing::printStats( string name )
+{
+	cout << "[" << name << "] spared rows " << stat_n_rows << " cols " << stat_n_cols << " banks " << stat_n_banks
+	     << " chips " << stat_n_chips << " retired_ranges " << stat_n_retired << "\n";
+}
+
+void Sparing::resetStats( void )
+{
+	stat_n_rows = stat_n_cols = stat_n_banks = stat_n_chips = stat_n_retired = 0;
+}
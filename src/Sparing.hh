@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef SPARING_HH_
+#define SPARING_HH_
+
+#include "boost/cstdint.hpp"
+#include <vector>
+#include <string>
+#include "FaultDomain.hh"
+
+class DRAMDomain;
+class FaultStore;
+
+using namespace std;
+
+// Spare resources of a module that permanent faults are retired into at every scrub, as row and
+// column sparing (post-package repair), bank sparing and chip sparing do. Each chip has a budget of
+// spare rows and spare columns per bank and of spare banks, and the module a budget of spare chips.
+//
+// A permanent fault takes the smallest spare that covers it: a row for faults within one row, a
+// column for faults within one column of a bank, a bank for faults within one bank, and a chip for
+// the rest. Once that budget is used up it takes the next larger spare, except that a fault within
+// one row or column never takes a whole bank or chip. Every permanent fault within the spared region
+// leaves the chip, including those its on-die code was correcting (the spare holds the corrected
+// data), and faults that arrive later are faults of the spare. A spare chip comes with budgets of its
+// own. Transient faults are left to the scrub, and TSV faults to the redundant TSVs of the stack.
+
+class Sparing
+{
+public:
+	Sparing( uint32_t rows, uint32_t cols, uint32_t banks, uint32_t chips );
+
+	// retire the permanent faults of the chips of a module that fit the remaining spares, returns
+	// the number of faults retired
+	uint64_t retire( FaultDomain *fd );
+	void reset( void );	// restore all spares for the next simulation
+
+	void printStats( string name );
+	void resetStats( void );
+
+private:
+	// spares used in one chip, and the faults of its store already looked at
+	struct ChipSpares
+	{
+		uint64_t generation;
+		uint32_t known;
+		vector<uint32_t> rows, cols;	// per rank and bank
+		uint32_t banks;
+	};
+
+	bool spare( DRAMDomain *pDRAM, ChipSpares &chip, uint64_t addr, uint64_t wild );
+	void take( FaultStore *pRange, uint64_t addr, uint64_t mask );	// spare a region, retiring every fault within it
+	void collect( FaultStore *pRange, uint64_t addr, uint64_t mask );
+	void collectRegions( FaultStore *pRange );	// the faults of the store within every region spared so far
+	void clearChip( ChipSpares &chip, uint32_t n_banks );
+
+	uint32_t m_rows, m_cols, m_banks, m_chips;	// budgets
+	vector<ChipSpares> m_chipSpares;
+	uint32_t m_chipsUsed;
+
+	// during retire(), for the current chip: the regions spared, and the faults within them
+	vector<uint64_t> m_regionAddr, m_regionMask;
+	vector<uint32_t> m_retired;
+	vector<uint8_t> m_isRetired;
+
+	// cross-simulation totals
+	uint64_t stat_n_rows, stat_n_cols, stat_n_banks, stat_n_chips, stat_n_retired;
+};
+
+
+#endif /* SPARING_HH_ */
@@ -0,0 +1,187 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SymbolRepair.hh"
+#include "DRAMDomain.hh"
+#include "IntersectKernel.hh"
+#include <algorithm>
+
+SymbolRepair::SymbolRepair( string name, const CodewordLayout &layout ) : RepairScheme( name )
+, m_layout(layout)
+, m_n_correct(layout.n_correct)
+, m_n_detect(layout.n_detect)
+{
+counter_prev=0;
+counter_now=0;
+m_covered.resize( ( (1ULL << layout.log_codeword) + 63 ) / 64 );
+}
+
+void SymbolRepair::repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t &n_uncorrectable )
+{
+	n_undetectable = n_uncorrectable = 0;
+
+	list<FaultDomain*> *pChips = fd->getChildren();
+	assert( m_layout.chips == 0 || pChips->size() == m_layout.chips );
+
+	list<FaultDomain*>::iterator it1;
+	for(it1 =pChips->begin(); it1 !=pChips->end(); it1++)
+	{
+		DRAMDomain *pDRAM3 = dynamic_cast<DRAMDomain*>((*it1));
+		pDRAM3->getRanges()->clearTouched();
+	}
+
+	evaluate( pChips, n_undetectable, n_uncorrectable );
+}
+
+void SymbolRepair::evaluate( list<FaultDomain*> *pChips, uint64_t &n_undetectable, uint64_t &n_uncorrectable )
+{
+	list<FaultDomain*>::iterator it0;
+	for( it0 = pChips->begin(); it0 != pChips->end(); it0++ )
+	{
+		FaultStore *pRange0 = dynamic_cast<DRAMDomain*>((*it0))->getRanges();
+
+		for( uint32_t i0 = 0; i0 < pRange0->size(); i0++ )
+		{
+			if( !pRange0->untouched( i0 ) ) continue;
+
+			uint64_t n_symbols = countSymbols( pChips, pRange0->getQuery( i0 ), max( m_n_correct, m_n_detect ) );
+			if( n_symbols > m_n_correct ) {
+				n_uncorrectable += n_symbols - m_n_correct;
+				flag( pRange0, i0 );
+			}
+			if( n_symbols > m_n_detect ) {
+				n_undetectable += n_symbols - m_n_detect;
+			}
+		}
+	}
+}
+
+void SymbolRepair::flag( FaultStore *pRange, uint32_t i )
+{
+	pRange->transient_remove[i] = false;
+}
+
+// A location of a codeword is faulty in a chip if a fault of the chip covers it. The faults of a
+// chip that meet any codeword the range is in together cover the union of their own locations,
+// which the candidates' coverage bitmaps give directly. With one symbol per chip, any candidate
+// makes the symbol faulty.
+//
+// A chip with a fault covering whole banks that meets the range has all its symbols faulty, which
+// the store tells in constant time, so those chips are counted first. Once the count is past
+// limit the verdict is settled and the rest is not counted. The scheme never touches faults, so
+// the faults with max_faults set are the untouched ones.
+
+uint32_t SymbolRepair::countSymbols( list<FaultDomain*> *pChips, FaultQuery q, uint32_t limit )
+{
+	uint32_t log_codeword = m_layout.log_codeword;
+	q.mask |= ( 1ULL << log_codeword ) - 1;
+
+	uint32_t n_symbols = 0;
+	uint32_t n_chips = 0;
+	list<FaultDomain*>::iterator it1;
+	for( it1 = pChips->begin(); it1 != pChips->end(); it1++, n_chips++ )
+	{
+		FaultStore *pRange1 = dynamic_cast<DRAMDomain*>((*it1))->getRanges();
+		if( n_chips == m_chips.size() ) m_chips.push_back( NULL );
+		if( pRange1->anyBankWide( q.addr, q.mask ) ) {
+			n_symbols += m_layout.getSymbolsPerChip();
+			if( n_symbols > limit ) return n_symbols;
+			pRange1 = NULL;
+		}
+		m_chips[n_chips] = pRange1;
+	}
+
+	for( uint32_t c = 0; c < n_chips && n_symbols <= limit; c++ )
+	{
+		FaultStore *pRange1 = m_chips[c];
+		if( pRange1 == NULL ) continue;
+
+		if( log_codeword == m_layout.log_symbol ) {
+			if( pRange1->anyIntersecting( q, true ) ) n_symbols++;
+			continue;
+		}
+
+		m_found.clear();
+		pRange1->collectIntersecting( q, m_found );
+		if( m_found.empty() ) continue;
+
+		fill( m_covered.begin(), m_covered.end(), 0 );
+		for( uint32_t k = 0; k < m_found.size(); k++ ) {
+			uint32_t i1 = m_found[k];
+			if( pRange1->untouched( i1 ) ) {
+				blockCoverage( pRange1->fAddr[i1], pRange1->fWildMask[i1], log_codeword, &m_covered[0] );
+			}
+		}
+		n_symbols += countCoveredSymbols();
+	}
+
+	return n_symbols;
+}
+
+// Symbols of m_covered with at least one covered location. Within a word, folding each symbol onto
+// its lowest bit leaves one bit per faulty symbol at the symbol starts.
+
+uint32_t SymbolRepair::countCoveredSymbols( void )
+{
+	uint32_t log_symbol = m_layout.log_symbol;
+	uint32_t n_symbols = 0;
+
+	if( log_symbol >= 6 ) {
+		uint32_t words = 1 << ( log_symbol - 6 );
+		for( uint32_t w = 0; w < m_covered.size(); w += words ) {
+			uint64_t any = 0;
+			for( uint32_t k = 0; k < words; k++ ) any |= m_covered[w + k];
+			if( any != 0 ) n_symbols++;
+		}
+		return n_symbols;
+	}
+
+	uint64_t starts = ~0ULL / ( ( 1ULL << ( 1 << log_symbol ) ) - 1 );
+	for( uint32_t w = 0; w < m_covered.size(); w++ ) {
+		uint64_t bits = m_covered[w];
+		for( uint32_t k = 0; k < log_symbol; k++ ) bits |= bits >> ( 1 << k );
+		n_symbols += __builtin_popcountll( bits & starts );
+	}
+	return n_symbols;
+}
+
+// A fault alone in its codewords only makes the symbols of its own chip that it covers faulty
+
+bool SymbolRepair::isolatedCorrectable( uint64_t fWildMask, uint32_t row_shift )
+{
+	if( m_layout.log_codeword > row_shift ) return false;
+
+	uint64_t symbol_bits = ( ( 1ULL << m_layout.log_codeword ) - 1 ) & ~( ( 1ULL << m_layout.log_symbol ) - 1 );
+	uint64_t n_symbols = 1ULL << __builtin_popcountll( fWildMask & symbol_bits );
+	return n_symbols <= m_n_correct;
+}
+
+uint32_t SymbolRepair::getCodewordBits( void )
+{
+	return m_layout.log_codeword;
+}
+
+void SymbolRepair::printStats( void )
+{
+	RepairScheme::printStats();
+}
+
+void SymbolRepair::clear_counters(void)
+{
+	counter_prev=0;
+	counter_now=0;
+}
+
+void SymbolRepair::resetStats( void )
+{
+	RepairScheme::resetStats();
+}
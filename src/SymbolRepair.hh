@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SYMBOLREPAIR_HH_
+#define SYMBOLREPAIR_HH_
+
+#include "RepairScheme.hh"
+#include "CodewordLayout.hh"
+#include "FaultStore.hh"
+#include <vector>
+
+// Symbol-based ECC described by a CodewordLayout. For every fault range, count the faulty symbols
+// of the codewords it is in, over all chips of the module. A fault with more than n_correct of
+// them is uncorrectable (and may not be scrubbed), more than n_detect undetectable.
+//
+// The faults of a chip that meet the codewords of a fault are found through the FaultStore index,
+// and the locations they cover are merged as bitmaps, so a codeword is counted in one pass over
+// these candidates.
+
+class SymbolRepair : public RepairScheme
+{
+public:
+	SymbolRepair( string name, const CodewordLayout &layout );
+
+	void repair( FaultDomain *fd, uint64_t &n_undetectable, uint64_t &n_uncorrectable );
+	uint32_t getCodewordBits( void );
+	bool isolatedCorrectable( uint64_t fWildMask, uint32_t row_shift );
+
+	void printStats( void );
+	void resetStats( void );
+	void clear_counters( void );
+
+protected:
+	// number of faulty symbols, over all chips, in the codewords the range is in; counting may stop
+	// once it is past limit
+	uint32_t countSymbols( list<FaultDomain*> *pChips, FaultQuery q, uint32_t limit );
+	// mark a fault uncorrectable, which keeps it from being scrubbed
+	void flag( FaultStore *pRange, uint32_t i );
+	virtual void evaluate( list<FaultDomain*> *pChips, uint64_t &n_undetectable, uint64_t &n_uncorrectable );
+
+	CodewordLayout m_layout;
+	uint64_t m_n_correct, m_n_detect;
+	uint64_t counter_prev, counter_now;
+
+private:
+	uint32_t countCoveredSymbols( void );
+
+	vector<FaultStore*> m_chips;	// stores of the chips a query still has to search, NULL once counted
+	vector<uint32_t> m_found;	// faults of a chip meeting the codewords of a fault
+	vector<uint64_t> m_covered;	// locations of a codeword covered by them
+};
+
+
+#endif /* SYMBOLREPAIR_HH_ */
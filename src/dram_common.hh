@@ -17,6 +17,8 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include <boost/random/uniform_real_distribution.hpp>
 #include <boost/random/variate_generator.hpp>
 #include <ctime>
+#include <cmath>
+#include <stdint.h>
 #include <sys/time.h>
 
 using namespace std;
@@ -35,4 +37,27 @@ typedef boost::mt19937_64                     ENG;    // Mersenne Twister
 typedef boost::random::uniform_real_distribution<double> DIST;
 typedef boost::random::variate_generator<ENG,DIST> GEN;    // Variate generator
 
+#define NO_FAULT_INTERVAL UINT64_MAX	// fault stream that never fires
+
+// Number of intervals without a fault before the next one in a stream of independent
+// per-interval Bernoulli trials with fault probability p. Drawn by inverting the
+// geometric distribution with a uniform random number u in [0,1).
+inline uint64_t geometricSkip( double u, double p )
+{
+	if( p <= 0 ) return NO_FAULT_INTERVAL;
+	if( p >= 1 ) return 0;
+
+	double k = floor( log1p( -u ) / log1p( -p ) );
+	if( k >= (double)( NO_FAULT_INTERVAL >> 1 ) ) return NO_FAULT_INTERVAL;
+
+	return (uint64_t)k;
+}
+
+// Interval of the next fault in a stream whose last fault (if any) happened in interval curr-1
+inline uint64_t geometricNext( uint64_t curr, double u, double p )
+{
+	uint64_t k = geometricSkip( u, p );
+	return ( k == NO_FAULT_INTERVAL ) ? NO_FAULT_INTERVAL : curr + k;
+}
+
 #endif /* DRAM_COMMON_HH_ */
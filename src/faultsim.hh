@@ -19,6 +19,12 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #define FM_UNIFORM_BIT 0
 #define FM_JAGUAR      1
 
+// Simulation engines (the values of sim_mode), and the pseudo-modes for "auto" and unrecognized values
+#define SIM_INTERVAL 1
+#define SIM_EVENT 2
+#define SIM_AUTO -1
+#define SIM_INVALID -2
+
 // Memory organizations
 #define MO_DIMM 0
 #define MO_3D 1
@@ -26,13 +26,23 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "BCHRepair_cube.hh"
 #include "CubeRAIDRepair.hh"
 #include "BCHRepair.hh"
+#include "SymbolRepair.hh"
+#include "CodewordLayout.hh"
 #include "Simulation.hh"
 #include "EventSimulation.hh"
 #include "Settings.hh"
+#include "FITProfile.hh"
+#include "CostModel.hh"
+#include "FaultRange.hh"
+#include "FaultRangeArena.hh"
+#include "IntersectKernel.hh"
+#include "Sparing.hh"
 
 void printBanner( void );
-GroupDomain* genModuleDIMM( void );
-GroupDomain* genModule3D( void );
+GroupDomain* genModuleDIMM( uint module_id );
+GroupDomain* genModule3D( uint module_id );
+void setFITProfiles( DRAMDomain *dram0 );
+void setSparing( GroupDomain *module );
 
 namespace {
 const size_t ERROR_IN_COMMAND_LINE = 1;
@@ -65,8 +75,9 @@ int main(int argc, char** argv) {
 		/** Prashant Adding Options for higher end BCH repair codes in the "mode" field and a test field to do primitive testing of cases */
 
 		desc.add_options()("help", "Print help messages")
-										  ("outfile", po::value<std::string>(&settings.output_file)->required(), "Output file name")
-                                          ("configfile",po::value<std::string>(&chain),"Indicate .ini configuration file to use");
+										  ("outfile", po::value<std::string>(&settings.output_file), "Output file name")
+                                          ("configfile",po::value<std::string>(&chain),"Indicate .ini configuration file to use")
+                                          ("dry-run", "Print the predicted run time of both simulators and exit");
 
 		po::variables_map vm;
 		try {
@@ -81,6 +92,11 @@ int main(int argc, char** argv) {
 
 			po::notify(vm); // throws on error, so do after help in case
 			// there are any problems
+
+			settings.dry_run = vm.count("dry-run");
+			if( !settings.dry_run && !vm.count("outfile") ) {
+				throw po::required_option("outfile");
+			}
 		} catch (po::error& e) {
 			std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
 			std::cerr << desc << std::endl;
@@ -103,13 +119,60 @@ int main(int argc, char** argv) {
 	parser(config_opt);
     delete [] config_opt;
 
+    if( settings.sim_mode == SIM_INVALID ) {
+    	cout << "ERROR: Invalid sim_mode option (must be 1 (interval-based), 2 (event-driven) or auto)\n";
+    	exit(0);
+    }
+
+    // FIT profiles are sampled by thinning the fault arrival process, which only the event-driven simulator does
+    if( settings.sim_mode == SIM_INTERVAL ) {
+    	for( int i = 0; i < DRAM_MAX; i++ ) {
+    		if( !settings.transient_profile[i].empty() || !settings.permanent_profile[i].empty() ) {
+    			cout << "ERROR: FIT profiles require the event-driven simulator (sim_mode 2)\n";
+    			exit(0);
+    		}
+    	}
+    }
+
+    // on-die codewords hold a power-of-two number of data bits from one row of a chip
+    if( settings.ondie_sec_bits != 0 && ( ( settings.ondie_sec_bits & ( settings.ondie_sec_bits - 1 ) ) != 0
+    		|| settings.ondie_sec_bits > settings.cols * settings.chip_bus_bits ) ) {
+    	cout << "ERROR: ondie_sec_bits must be a power of two of at most cols * chip_bus_bits\n";
+    	exit(0);
+    }
+
+    // the table of codeword layouts describes DIMM ranks, 3D stacks have their own repair schemes
+    if( settings.organization == MO_3D && settings.repairmode == 6 ) {
+    	cout << "ERROR: repairmode 6 (ECC layout) is only supported for DIMMs (organization 0)\n";
+    	exit(1);
+    }
+
+    FaultRange::arena = new FaultRangeArena( ARENA_CHUNK_BYTES, settings.huge_pages );
+    if( settings.verbose ) cout << "# Fault intersection kernel: " << intersectKernelName() << "\n";
+
     // Build the physical memory organization and attach ECC scheme /////
-    GroupDomain *module = NULL;
+    list<GroupDomain*> modules;
+
+    for( uint m = 0; m < settings.modules; m++ ) {
+    	if( settings.organization == MO_DIMM ) {
+    		modules.push_back( genModuleDIMM( m ) );
+    	} else if( settings.organization == MO_3D ) {
+    		modules.push_back( genModule3D( m ) );
+    	}
+    }
+
+    // Estimate the cost of both simulators before the FIT rates are scaled, and pick the cheaper one if asked to
+    CostModel cost( modules, settings.max_s, settings.interval_s, settings.fit_factor, settings.test_mode,
+    				settings.organization, settings.repairmode );
+
+    if( settings.dry_run ) {
+    	cost.printEstimate( settings.n_sims );
+    	return SUCCESS;
+    }
 
-    if( settings.organization == MO_DIMM ) {
-    	module = genModuleDIMM();
-    } else if( settings.organization == MO_3D ) {
-    	module = genModule3D();
+    if( settings.sim_mode == SIM_AUTO ) {
+    	settings.sim_mode = cost.selectMode();
+    	if( settings.verbose ) cost.printEstimate( settings.n_sims );
     }
 
     // Configure simulator ///////////////////////////////////////////////
@@ -128,21 +191,23 @@ int main(int argc, char** argv) {
     // ECC technique and also stress corner cases for fault specific ECC.
     // NOTE: The test_mode setting is currently not implemented in the Event Based Simulator
 
-    if( settings.sim_mode == 1 ) {
+    if( settings.sim_mode == SIM_INTERVAL ) {
     	sim_temp = (new Simulation( settings.interval_s, settings.scrub_s, settings.fit_factor, settings.test_mode,
     			                    settings.debug,settings.continue_running, settings.output_bucket_s ));
-    } else if( settings.sim_mode == 2 ) {
+    } else if( settings.sim_mode == SIM_EVENT ) {
     	sim_temp = (new EventSimulation( settings.interval_s, settings.scrub_s, settings.fit_factor, settings.test_mode,
     								settings.debug,settings.continue_running, settings.output_bucket_s ));
     } else {
-    	cout << "ERROR: Invalid sim_mode option (must be 1 (interval-based) or 2 (event-driven))\n";
-    	exit(0);
+    	assert(0);
     }
 
     Simulation &sim = *sim_temp;
 
     // Run simulator //////////////////////////////////////////////////
-    sim.addDomain( module );    // register the top-level memory object with the simulation engine
+    // register the top-level memory objects with the simulation engine
+    for( list<GroupDomain*>::iterator it = modules.begin(); it != modules.end(); it++ ) {
+    	sim.addDomain( *it );
+    }
     sim.init( settings.max_s );	// one-time set-up that does FIT rate scaling based on interval
     sim.simulate( settings.max_s, settings.n_sims, settings.verbose, settings.output_file);
     sim.printStats();
@@ -150,23 +215,64 @@ int main(int argc, char** argv) {
 	return SUCCESS;
 
 }
+/*
+ * Attach the configured FIT profiles to a DRAM. Profiles are shared by all DRAMs.
+ */
+
+void setFITProfiles( DRAMDomain *dram0 )
+{
+	static FITProfile *transient_profiles[DRAM_MAX] = { NULL };
+	static FITProfile *permanent_profiles[DRAM_MAX] = { NULL };
+
+	for( int i = 0; i < DRAM_MAX; i++ ) {
+		if( !settings.transient_profile[i].empty() ) {
+			if( transient_profiles[i] == NULL ) transient_profiles[i] = new FITProfile( settings.transient_profile[i] );
+			dram0->setFITProfile( i, 1, transient_profiles[i] );
+		}
+
+		if( !settings.permanent_profile[i].empty() ) {
+			if( permanent_profiles[i] == NULL ) permanent_profiles[i] = new FITProfile( settings.permanent_profile[i] );
+			dram0->setFITProfile( i, 0, permanent_profiles[i] );
+		}
+	}
+}
+
+/*
+ * Give the repair scheme of a module the configured spares. Without a repair scheme the first
+ * fault fails the simulation, and there is nothing to spare.
+ */
+
+void setSparing( GroupDomain *module )
+{
+	if( settings.spare_rows == 0 && settings.spare_cols == 0 && settings.spare_banks == 0 && settings.spare_chips == 0 ) return;
+	if( module->m_repairSchemes.empty() ) return;
+
+	module->m_repairSchemes.front()->setSparing( new Sparing( settings.spare_rows, settings.spare_cols,
+			settings.spare_banks, settings.spare_chips ) );
+}
+
 /*
  * Simulate a DIMM module
  */
 
-GroupDomain* genModuleDIMM( void )
+GroupDomain* genModuleDIMM( uint module_id )
 {
 	GroupDomain *dimm0;
+	char modname[20];
+	snprintf( modname, sizeof( modname ), "MODULE%u", module_id );
 
 	// Create a DIMM or a CUBE
 	// settings.data_block_bits is the number of bits per transaction when you create a DIMM
 
-	dimm0 = new GroupDomain_dimm( "MODULE0", settings.chips_per_rank, settings.banks, settings.data_block_bits );
+	dimm0 = new GroupDomain_dimm( modname, settings.chips_per_rank, settings.banks, settings.data_block_bits );
 
 	for( uint32_t i = 0; i < settings.chips_per_rank; i++ ) {
-		char buf[20];
-		sprintf( buf, "MODULE0.DRAM%d", i );
+		char buf[40];
+		snprintf( buf, sizeof( buf ), "%s.DRAM%u", modname, i );
 		DRAMDomain *dram0 = new DRAMDomain( buf, settings.chip_bus_bits, settings.ranks, settings.banks, settings.rows, settings.cols );
+		// the DIMM schemes only ask whether a chip has a fault intersecting a range, so faults
+		// contained in another one of the same chip can be set aside
+		dram0->getRanges()->setCoalescing( true );
 
 		if( settings.faultmode == FM_UNIFORM_BIT ) {
 			if( settings.enable_transient ) dram0->setFIT( DRAM_1BIT, 1, 33.05 );
@@ -195,6 +301,8 @@ GroupDomain* genModuleDIMM( void )
 			assert(0);
 		}
 
+		setFITProfiles( dram0 );
+		if( settings.ondie_sec_bits != 0 ) dram0->setOnDieECC( settings.ondie_sec_bits );
 		dimm0->addDomain( dram0, i );
 	}
 
@@ -202,35 +310,51 @@ GroupDomain* genModuleDIMM( void )
 	if( settings.repairmode == 0 ) {
 		// do nothing (no ECC)
 	} else if( settings.repairmode == 1 ) {
-		ChipKillRepair *ck0 = new ChipKillRepair( string("CK1"), 1, 2 );
+		ChipKillRepair *ck0 = new ChipKillRepair( string("CK1"), *CodewordLayout::find( "CK1" ) );
 		dimm0->addRepair( ck0 );
 	} else if( settings.repairmode == 2 ) {
-		ChipKillRepair *ck0 = new ChipKillRepair( string("CK2"), 2, 4 );
+		ChipKillRepair *ck0 = new ChipKillRepair( string("CK2"), *CodewordLayout::find( "CK2" ) );
 		dimm0->addRepair( ck0 );
 	} else if( settings.repairmode == 3 ) {
-		BCHRepair *bch0 = new BCHRepair( string("SECDED"), 1, 2, 4 );
+		BCHRepair *bch0 = new BCHRepair( string("SECDED"), *CodewordLayout::find( "SECDED" ) );
 		dimm0->addRepair( bch0 );
 	} else if( settings.repairmode == 4 ) {
-		BCHRepair *bch1 = new BCHRepair( string("3EC4ED"), 3, 4, 4 );
+		BCHRepair *bch1 = new BCHRepair( string("3EC4ED"), *CodewordLayout::find( "3EC4ED" ) );
 		dimm0->addRepair( bch1 ); //Repair from Fault Domain
 	} else if( settings.repairmode == 5 ) {
-		BCHRepair *bch2 = new BCHRepair( string("6EC7ED"), 6, 7, 4 );
+		BCHRepair *bch2 = new BCHRepair( string("6EC7ED"), *CodewordLayout::find( "6EC7ED" ) );
 		dimm0->addRepair( bch2 );
+	} else if( settings.repairmode == 6 ) {
+		// any symbol code from the table of layouts
+		const CodewordLayout *layout = CodewordLayout::find( settings.ecc_layout );
+		if( layout == NULL || ( layout->chips != 0 && layout->chips != settings.chips_per_rank )
+				|| ( layout->device_bits != 0 && layout->device_bits != settings.chip_bus_bits ) ) {
+			cout << "ERROR: ECC layout '" << settings.ecc_layout << "' does not fit " << settings.chips_per_rank
+			     << " x" << settings.chip_bus_bits << " chips, the layouts are:\n";
+			CodewordLayout::printLayouts();
+			exit(1);
+		}
+		SymbolRepair *sym0 = new SymbolRepair( settings.ecc_layout, *layout );
+		dimm0->addRepair( sym0 );
 	} else {
 		assert(0);
 	}
 
+	setSparing( dimm0 );
+
 	return dimm0;
 }
 
-GroupDomain *genModule3D( void )
+GroupDomain *genModule3D( uint module_id )
 {
 	GroupDomain *stack0;
+	char modname[20];
+	snprintf( modname, sizeof( modname ), "MODULE%u", module_id );
 
 	// Create a stack or a CUBE
 	// settings.data_block_bits is the number of bits per transaction when you create a Cube
 	         
-	stack0 = new GroupDomain_cube( "MODULE0",1,settings.chips_per_rank,settings.banks,settings.data_block_bits,settings.cube_addr_dec_depth, settings.cube_ecc_tsv, settings.cube_redun_tsv, settings.enable_tsv);
+	stack0 = new GroupDomain_cube( modname,1,settings.chips_per_rank,settings.banks,settings.data_block_bits,settings.cube_addr_dec_depth, settings.cube_ecc_tsv, settings.cube_redun_tsv, settings.enable_tsv);
 
 	//Set FIT rates for TSVs, these are set at the GroupDomain level as these are common to the entire cube
 	stack0->setFIT_TSV( 1, settings.tsv_fit );
@@ -245,8 +369,8 @@ GroupDomain *genModule3D( void )
 	DRAM_nrank_fit_perm = 0.0;
 
 	for( uint32_t i = 0; i < settings.chips_per_rank; i++ ) {
-		char buf[20];
-		sprintf( buf, "MODULE0.DRAM%d", i );
+		char buf[40];
+		snprintf( buf, sizeof( buf ), "%s.DRAM%u", modname, i );
 		DRAMDomain *dram0 = new DRAMDomain( buf, settings.chip_bus_bits, settings.ranks, settings.banks, settings.rows, settings.cols );
 
 		if( settings.faultmode == FM_UNIFORM_BIT ) {
@@ -277,6 +401,8 @@ GroupDomain *genModule3D( void )
 			assert(0);
 		}
 
+		setFITProfiles( dram0 );
+		if( settings.ondie_sec_bits != 0 ) dram0->setOnDieECC( settings.ondie_sec_bits );
 		stack0->addDomain( dram0, i );
 	}
 
@@ -296,9 +422,8 @@ GroupDomain *genModule3D( void )
 		BCHRepair_cube *bch2 = new BCHRepair_cube( string("6EC7ED"), 6, 7, settings.data_block_bits );
 		stack0->addRepair( bch2 );
 	}
-	else if( settings.repairmode == 6 ) {
-		assert(0);
-	}
+
+	setSparing( stack0 );
 
 	return stack0;
 }